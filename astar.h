@@ -4,30 +4,84 @@
 #include <vector>
 #include <memory>
 #include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <bit>
 #include <functional>
+#include <concepts>
+#include <type_traits>
+#include "openlist.h"
+#include "landmarks.h"
 
 class BlockAllocator;
 
-class AStar
+/**
+ * 寻路公共类型
+ */
+struct AStarTypes
+{
+    static const int kStepValue = 10;       // 默认直行估值
+    static const int kObliqueValue = 14;    // 默认拐角估值
+
+    /**
+     * 8邻域方向，偶数位为直行，奇数位为斜向
+     * 地图类型提供 get_neighbour_mask(const Vec2&) 时按此顺序返回可通过掩码
+     */
+    static constexpr int kNeighbourX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+    static constexpr int kNeighbourY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static constexpr uint8_t kStraightMask = 0x55;
+
+    /**
+     * 搜索方式
+     */
+    enum Mode
+    {
+        NORMAL,                 // 逐格扩展
+        JPS,                    // 跳点搜索，要求直行和斜向的代价各自相同，
+                                // 地图预计算了跳跃距离时按 JPS+ 查表跳跃
+        THETA                   // 任意角度搜索(Lazy Theta*)，父节点可以是任意可直视的节点，
+                                // 代价为欧氏距离，路径只包含拐点和终点
+    };
+
+    /**
+     * 启发函数
+     */
+    enum Heuristic
+    {
+        AUTO,                   // 按移动方式选择：任意角度为欧氏距离，允许拐角为对角距离，否则为曼哈顿距离
+        MANHATTAN,              // 曼哈顿距离，允许拐角时不可采纳
+        OCTILE,                 // 对角距离，与8方向移动代价一致
+        EUCLIDEAN               // 欧氏距离
+    };
+};
+
+/**
+ * 与坐标类型相关的寻路类型
+ * Coord 为坐标类型，同一坐标类型的各种 BasicAStar 共用这些类型
+ */
+template<typename Coord>
+struct BasicAStarTypes : public AStarTypes
 {
-public:
     /**
      * 二维向量
      */
     struct Vec2
     {
-        uint16_t x;
-        uint16_t y;
+        Coord x;
+        Coord y;
 
         Vec2() : x(0) , y(0)
         {
         }
 
-        Vec2(uint16_t x1, uint16_t y1) : x(x1), y(y1)
+        Vec2(Coord x1, Coord y1) : x(x1), y(y1)
         {
         }
 
-        void reset(uint16_t x1, uint16_t y1)
+        void reset(Coord x1, Coord y1)
         {
             x = x1;
             y = y1;
@@ -35,7 +89,7 @@ public:
 
         int distance(const Vec2 &other) const
         {
-            return abs(other.x - x) + abs(other.y - y);
+            return int(std::abs(int64_t(other.x) - x) + std::abs(int64_t(other.y) - y));
         }
 
         bool operator== (const Vec2 &other) const
@@ -52,16 +106,37 @@ public:
     struct Params
     {
         bool        corner;     // 允许拐角
-        uint16_t    height;     // 地图高度
-        uint16_t    width;      // 地图宽度
+        Coord       height;     // 地图高度
+        Coord       width;      // 地图宽度
         Vec2        start;      // 起点坐标
         Vec2        end;        // 终点坐标
         Callback    can_pass;   // 是否可通过
+        Mode        mode;       // 搜索方式
+        Heuristic   heuristic;  // 启发函数
+        float       weight;     // 启发函数权重(不小于1)，大于1时为加权A*，
+                                // 启发函数一致时路径代价不超过最优的weight倍
+        bool        nearest;    // 终点不可到达时，返回到可到达的格子中离终点最近的格子的路径
+        uint32_t    goal_limit; // 多终点寻路时启发函数只考虑离起点最近的若干个尚未到达的终点，为0时考虑全部
 
-        Params() : height(0), width(0), corner(false)
+        Params() : corner(false), height(0), width(0), mode(NORMAL), heuristic(AUTO), weight(1.0f), nearest(false), goal_limit(0)
         {
         }
     };
+};
+
+/**
+ * A*寻路
+ * OpenList 为开启列表的实现，见 openlist.h
+ * Coord 为坐标类型，Cost 为节点表中G值和H值的类型，超出范围的代价按最大值处理。
+ * 节点索引为32位，要求 width*height 小于 2^32
+ */
+template<typename OpenList, typename Coord = uint16_t, typename Cost = uint16_t>
+class BasicAStar : public AStarTypes
+{
+public:
+    typedef typename BasicAStarTypes<Coord>::Vec2 Vec2;
+    typedef typename BasicAStarTypes<Coord>::Callback Callback;
+    typedef typename BasicAStarTypes<Coord>::Params Params;
 
 private:
     /**
@@ -74,35 +149,74 @@ private:
         IN_CLOSEDLIST           // 在关闭列表
     };
 
+    static const uint32_t kNoParent = UINT32_MAX;
+
+public:
+    /**
+     * 分帧寻路的状态
+     */
+    enum SearchState
+    {
+        SEARCHING,              // 尚未结束，可以继续
+        FOUND,                  // 找到终点
+        NOT_FOUND               // 终点不可到达或搜索已失效
+    };
+
     /**
-     * 路径节点
+     * 分帧寻路句柄
+     * 节点表保存在 BasicAStar 中，同一个 BasicAStar 开始新的寻路后旧句柄失效。
+     * GridPolicy 为左值引用时只保存引用，地图需要在搜索期间保持有效
      */
-    struct Node
+    template<typename GridPolicy>
+    class Search
     {
-        uint16_t    g;          // 与起点距离
-        uint16_t    h;          // 与终点距离
-        Vec2        pos;        // 节点位置
-        NodeState   state;      // 节点状态
-        Node*       parent;     // 父节点
+    public:
+        Search(BasicAStar *algorithm, GridPolicy &&can_pass);
 
+    public:
         /**
-         * 计算f值
+         * 继续寻路，最多扩展 budget 个节点
          */
-        int f() const
-        {
-            return g + h;
-        }
+        SearchState resume(size_t budget);
 
-        inline Node(const Vec2 &pos)
-            : g(0), h(0), pos(pos), parent(nullptr), state(NOTEXIST)
-        {
-        }
+        /**
+         * 获取寻路状态
+         */
+        SearchState get_state() const;
+
+        /**
+         * 获取路径，与 find 的结果一致。
+         * 尚未结束时返回到目前扩展过的节点中离终点最近的一个的路径，可以先沿此路径移动
+         */
+        std::vector<Vec2> get_path() const;
+
+    private:
+        /**
+         * 句柄是否仍然有效
+         */
+        bool is_current() const;
+
+    private:
+        friend class BasicAStar;
+
+        BasicAStar*     algorithm_;
+        GridPolicy      can_pass_;
+        uint32_t        serial_;        // 开始寻路时的编号
     };
 
 public:
-    AStar(BlockAllocator *allocator);
+    /**
+     * 节点数据按 y*width+x 存放在连续数组中，并在多次寻路之间保留，
+     * 地图尺寸不变时每次寻路的初始化和清理只与访问过的节点数有关
+     */
+    BasicAStar();
+
+    /**
+     * 兼容旧接口，节点不再从分配器中分配，参数不再使用
+     */
+    explicit BasicAStar(BlockAllocator *allocator);
 
-    ~AStar();
+    ~BasicAStar();
 
 public:
     /**
@@ -125,11 +239,61 @@ public:
      */
     void set_oblique_value(int value);
 
+    /**
+     * 设置 ALT 路标，为空时不使用。启发函数取几何距离与路标下界中较大的一个，
+     * 只在路标与地图尺寸、代价一致，地图版本未变化(地图类型提供 get_revision 时)，
+     * 且不是任意角度搜索时使用。路标需要在使用期间保持有效
+     */
+    void set_landmarks(const Landmarks *landmarks);
+
+    /**
+     * 获取 ALT 路标
+     */
+    const Landmarks* get_landmarks() const;
+
     /**
      * 执行寻路操作
      */
     std::vector<Vec2> find(const Params &param);
 
+    /**
+     * 执行寻路操作，可通过性在编译期确定
+     * can_pass 为可调用对象 bool(const Vec2&)，或带有 can_pass(const Vec2&) 成员的地图类型，
+     * 忽略 param.can_pass。
+     * 地图类型提供连通区域编号(get_component)时，终点不可到达的请求不经搜索直接返回
+     */
+    template<typename GridPolicy>
+    std::vector<Vec2> find(const Params &param, GridPolicy &&can_pass);
+
+    /**
+     * 分帧寻路，先扩展最多 budget 个节点，返回的句柄在之后的帧中继续寻路，
+     * 全部完成后的路径与一次完成的 find 相同
+     */
+    template<typename GridPolicy>
+    Search<GridPolicy> find(const Params &param, GridPolicy &&can_pass, size_t budget);
+
+    /**
+     * 多终点寻路，一次搜索找到 ends 中代价最小的可到达终点，输出它在 ends 中的下标和路径，
+     * 全部不可到达时返回false。启发函数取到各个尚未到达的终点的最小值，
+     * param.goal_limit 限制参与计算的终点数时搜索更集中，但找到的不一定是代价最小的终点。
+     * 忽略 param.end 和 param.nearest，按逐格扩展搜索，不使用路标
+     */
+    template<typename GridPolicy>
+    bool find_nearest(const Params &param, const std::vector<Vec2> &ends, GridPolicy &&can_pass, size_t *out_end, std::vector<Vec2> *out_paths);
+
+    /**
+     * 多终点寻路，一次搜索找到到达 ends 中每个终点的最优路径，按 ends 的顺序输出，
+     * 不可到达或与起点相同的终点路径为空，返回可到达的终点数。
+     * 每到达一个终点，启发函数改为取剩余终点的最小值，param.goal_limit 只影响搜索的节点数
+     */
+    template<typename GridPolicy>
+    size_t find_all(const Params &param, const std::vector<Vec2> &ends, GridPolicy &&can_pass, std::vector<std::vector<Vec2>> *out_paths);
+
+    /**
+     * 获取上次寻路扩展的节点数，分帧寻路为目前累计的节点数
+     */
+    size_t get_expanded_count() const;
+
 private:
     /**
      * 清理参数
@@ -148,69 +312,1507 @@ private:
 
 private:
     /**
-     * 二叉堆上滤
+     * 节点放入开启列表
+     */
+    void push_open_list(uint32_t index);
+
+    /**
+     * 取出f值最小节点，开启列表为空时返回kNoParent
      */
-    void percolate_up(size_t hole);
+    uint32_t pop_open_list();
 
     /**
-     * 获取节点索引
+     * 坐标转换为节点索引
      */
-    bool get_node_index(Node *node, size_t *index);
+    uint32_t to_index(const Vec2 &pos) const;
+
+    /**
+     * 节点索引转换为坐标
+     */
+    Vec2 to_pos(uint32_t index) const;
+
+    /**
+     * 获取节点状态
+     */
+    NodeState get_state(uint32_t index) const;
 
     /**
      * 计算G值
      */
-    uint16_t calcul_g_value(Node *parent, const Vec2 &current);
+    Cost calcul_g_value(uint32_t parent, const Vec2 &current);
+
+    /**
+     * 计算H值
+     */
+    Cost calcul_h_value(const Vec2 &current, const Vec2 &end);
 
     /**
-     * 计算F值
+     * 计算开启列表的排序值，不超过32位
      */
-    uint16_t calcul_h_value(const Vec2 &current, const Vec2 &end);
+    static uint32_t calcul_f_value(Cost g_value, Cost h_value);
+
+    /**
+     * 代价超出 Cost 的范围时取最大值
+     */
+    static Cost saturate(uint64_t value);
 
     /**
      * 节点是否存在于开启列表
      */
-    bool in_open_list(const Vec2 &pos, Node *&out_node);
+    bool in_open_list(const Vec2 &pos);
 
     /**
      * 节点是否存在于关闭列表
      */
     bool in_closed_list(const Vec2 &pos);
 
+    /**
+     * 调用可通过性策略
+     */
+    template<typename GridPolicy>
+    static bool test_pass(GridPolicy &can_pass, const Vec2 &pos);
+
     /**
      * 是否可通过
      */
-    bool can_pass(const Vec2 &pos);
+    template<typename GridPolicy>
+    bool can_pass(GridPolicy &can_pass, const Vec2 &pos);
 
     /**
      * 当前点是否可到达目标点
      */
-    bool can_pass(const Vec2 &current, const Vec2 &destination, bool allow_corner);
+    template<typename GridPolicy>
+    bool can_pass(GridPolicy &can_pass, const Vec2 &current, const Vec2 &destination, bool allow_corner);
 
     /**
      * 查找附近可通过的节点
      */
-    void find_can_pass_nodes(const Vec2 &current, bool allow_corner, std::vector<Vec2> *out_lists);
+    template<typename GridPolicy>
+    void find_can_pass_nodes(GridPolicy &can_pass, const Vec2 &current, bool allow_corner, std::vector<Vec2> *out_lists);
+
+    /**
+     * 格子是否可通过，越界返回false
+     */
+    template<typename GridPolicy>
+    bool walkable(GridPolicy &can_pass, int x, int y);
+
+    /**
+     * 沿方向跳跃查找跳点
+     */
+    template<typename GridPolicy>
+    bool jump(GridPolicy &can_pass, int x, int y, int dx, int dy, const Vec2 &end, bool allow_corner, Vec2 *out_node);
+
+    /**
+     * 按预计算的跳跃距离查找跳点
+     */
+    template<typename GridPolicy>
+    bool jump_by_table(GridPolicy &can_pass, const Vec2 &pos, int dx, int dy, const Vec2 &end, bool allow_corner, Vec2 *out_node);
+
+    /**
+     * 查找当前节点的后继跳点
+     */
+    template<typename GridPolicy>
+    void find_jump_nodes(GridPolicy &can_pass, uint32_t current, const Vec2 &end, bool allow_corner, std::vector<Vec2> *out_lists);
+
+    /**
+     * 两个格子中心的连线是否只经过可通过的格子
+     */
+    template<typename GridPolicy>
+    bool line_of_sight(GridPolicy &can_pass, const Vec2 &from, const Vec2 &to);
+
+    /**
+     * 父节点不可直视时，从关闭列表中的邻居里重新选择父节点
+     */
+    template<typename GridPolicy>
+    void update_theta_parent(GridPolicy &can_pass, uint32_t current, bool allow_corner);
+
+    /**
+     * 按连通区域查找离终点最近的可到达格子，从终点向外逐圈扫描
+     */
+    template<typename GridPolicy>
+    bool find_nearest_reachable(GridPolicy &can_pass, uint32_t component, const Vec2 &end, Vec2 *out_node);
+
+    /**
+     * 开始寻路，检查参数并放入起点，终点不可到达时直接结束
+     */
+    template<typename GridPolicy>
+    void start_search(const Params &param, GridPolicy &can_pass);
+
+    /**
+     * 继续寻路，最多扩展 budget 个节点，结束时清理开启列表
+     */
+    template<typename GridPolicy>
+    SearchState continue_search(GridPolicy &can_pass, size_t budget);
+
+    /**
+     * 按当前的寻路状态生成路径
+     */
+    void build_search_path(std::vector<Vec2> *out_paths) const;
+
+    /**
+     * 多终点寻路，每到达一个终点调用 on_goal(终点在 ends 中的下标, 节点索引)，返回false时停止
+     */
+    template<typename GridPolicy, typename OnGoal>
+    void search_goals(const Params &param, const std::vector<Vec2> &ends, GridPolicy &can_pass, OnGoal &&on_goal);
+
+    /**
+     * 计算到多个终点的H值，取参与计算的尚未到达的终点中的最小值
+     */
+    Cost calcul_goals_h_value(const Vec2 &current);
+
+    /**
+     * 参与计算的终点变化后按新的H值重建开启列表
+     */
+    void rebuild_goals_open_list();
+
+    /**
+     * 回溯生成路径，interpolate 为 true 时在跳点之间补全经过的格子
+     */
+    void build_path(uint32_t end, bool interpolate, std::vector<Vec2> *out_paths) const;
 
     /**
      * 处理找到节点的情况
      */
-    void handle_found_node(Node *current, Node *destination);
+    void handle_found_node(uint32_t current, const Vec2 &destination);
 
     /**
      * 处理未找到节点的情况
      */
-    void handle_not_found_node(Node *current, Node *destination, const Vec2 &end);
+    void handle_not_found_node(uint32_t current, const Vec2 &destination, const Vec2 &end);
+
+private:
+    /**
+     * 多终点寻路尚未到达的终点
+     */
+    struct Goal
+    {
+        Vec2        pos;
+        uint32_t    index;      // 节点索引
+        uint32_t    end;        // 在 ends 中的下标
+    };
 
 private:
     int                     step_val_;
     int                     oblique_val_;
-    std::vector<Node*>      mapping_;
-    uint16_t                height_;
-    uint16_t                width_;
-    Callback                can_pass_;
-    std::vector<Node*>      open_list_;
-    BlockAllocator*         allocator_;
+    Mode                    mode_;          // 本次搜索方式
+    Heuristic               heuristic_;     // 本次使用的启发函数
+    const Landmarks*        landmarks_;     // ALT 路标
+    bool                    use_landmarks_; // 本次寻路是否使用路标
+    uint32_t                landmark_end_;  // 已读取路标代价的终点
+    std::vector<uint32_t>   landmark_end_distances_;
+    float                   weight_;        // 启发函数权重
+    std::vector<Cost>       g_;             // 与起点距离
+    std::vector<Cost>       h_;             // 与终点距离
+    std::vector<uint32_t>   parent_;        // 父节点索引
+    std::vector<uint32_t>   states_;        // 节点状态，等于generation_为开启，加一为关闭
+    uint32_t                generation_;
+    Coord                   height_;
+    Coord                   width_;
+    OpenList                open_list_;
+    size_t                  expanded_;
+    SearchState             state_;         // 本次寻路状态
+    uint32_t                serial_;        // 寻路编号，用于判断句柄是否失效
+    uint32_t                start_index_;
+    uint32_t                end_index_;
+    uint32_t                closest_;       // 扩展过的节点中离终点最近的节点
+    Vec2                    end_;           // 本次寻路的终点，可能已替换为最近的可到达格子
+    bool                    corner_;
+    bool                    nearest_;
+    std::vector<Vec2>       nearby_nodes_;
+    std::vector<Goal>       goals_;         // 多终点寻路尚未到达的终点，按与起点的H值排序
+    std::vector<uint32_t>   goal_indices_;  // 尚未到达的终点的节点索引，已排序
+    std::vector<uint32_t>   goal_opened_;   // 多终点寻路放入过开启列表的节点
+    size_t                  goal_limit_;    // 参与计算H值的终点数
 };
 
+/**
+ * 默认使用二叉堆作为开启列表，16位坐标和代价，每个节点占用16字节，
+ * 直行代价为10时最长约6500格的路径，更长的路径代价按最大值处理，结果可能不是最优
+ */
+typedef BasicAStar<BinaryHeap> AStar;
+
+/**
+ * 大地图使用32位代价，坐标与 AStar 相同，最大支持65535x65535的地图，
+ * 与 AStar 共用 Vec2 和 Params，可以直接使用 GridMap
+ */
+typedef BasicAStar<BinaryHeap, uint16_t, uint32_t> WideAStar;
+
+extern template class BasicAStar<BinaryHeap>;
+extern template class BasicAStar<RadixHeap>;
+extern template class BasicAStar<BinaryHeap, uint16_t, uint32_t>;
+extern template class BasicAStar<RadixHeap, uint16_t, uint32_t>;
+extern template class BasicAStar<BinaryHeap, uint32_t, uint32_t>;
+
+template<typename OpenList, typename Coord, typename Cost>
+BasicAStar<OpenList, Coord, Cost>::BasicAStar()
+    : step_val_(kStepValue)
+    , oblique_val_(kObliqueValue)
+    , mode_(NORMAL)
+    , heuristic_(MANHATTAN)
+    , landmarks_(nullptr)
+    , use_landmarks_(false)
+    , landmark_end_(kNoParent)
+    , weight_(1.0f)
+    , generation_(0)
+    , height_(0)
+    , width_(0)
+    , expanded_(0)
+    , state_(NOT_FOUND)
+    , serial_(0)
+    , start_index_(kNoParent)
+    , end_index_(kNoParent)
+    , closest_(kNoParent)
+    , corner_(false)
+    , nearest_(false)
+    , goal_limit_(SIZE_MAX)
+{
+}
+
+template<typename OpenList, typename Coord, typename Cost>
+BasicAStar<OpenList, Coord, Cost>::BasicAStar([[maybe_unused]] BlockAllocator *allocator)
+    : BasicAStar()
+{
+}
+
+template<typename OpenList, typename Coord, typename Cost>
+BasicAStar<OpenList, Coord, Cost>::~BasicAStar()
+{
+    clear();
+}
+
+// 获取直行估值
+template<typename OpenList, typename Coord, typename Cost>
+int BasicAStar<OpenList, Coord, Cost>::get_step_value() const
+{
+    return step_val_;
+}
+
+// 获取拐角估值
+template<typename OpenList, typename Coord, typename Cost>
+int BasicAStar<OpenList, Coord, Cost>::get_oblique_value() const
+{
+    return oblique_val_;
+}
+
+// 设置直行估值
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::set_step_value(int value)
+{
+    step_val_ = value;
+}
+
+// 获取拐角估值
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::set_oblique_value(int value)
+{
+    oblique_val_ = value;
+}
+
+// 设置 ALT 路标
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::set_landmarks(const Landmarks *landmarks)
+{
+    landmarks_ = landmarks;
+}
+
+// 获取 ALT 路标
+template<typename OpenList, typename Coord, typename Cost>
+const Landmarks* BasicAStar<OpenList, Coord, Cost>::get_landmarks() const
+{
+    return landmarks_;
+}
+
+// 获取上次寻路扩展的节点数
+template<typename OpenList, typename Coord, typename Cost>
+size_t BasicAStar<OpenList, Coord, Cost>::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 清理参数
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::clear()
+{
+    open_list_.clear();
+}
+
+// 初始化操作
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::init(const Params &param)
+{
+    mode_ = param.mode;
+    heuristic_ = param.heuristic;
+    if (heuristic_ == AUTO)
+    {
+        heuristic_ = param.mode == THETA ? EUCLIDEAN : (param.corner ? OCTILE : MANHATTAN);
+    }
+    weight_ = std::max(param.weight, 1.0f);
+
+    // 地图尺寸变化时才重建节点表
+    if (width_ != param.width || height_ != param.height)
+    {
+        width_ = param.width;
+        height_ = param.height;
+        const size_t size = size_t(width_) * height_;
+        g_.resize(size);
+        h_.resize(size);
+        parent_.resize(size);
+        open_list_.reset(size);
+        states_.assign(size, 0);
+        generation_ = 0;
+    }
+
+    // 新的搜索代数，上一次搜索留下的节点自动失效
+    generation_ += 2;
+    if (generation_ < 2)
+    {
+        std::fill(states_.begin(), states_.end(), 0);
+        generation_ = 2;
+    }
+}
+
+// 参数是否有效
+template<typename OpenList, typename Coord, typename Cost>
+bool BasicAStar<OpenList, Coord, Cost>::is_vlid_params(const Params &param)
+{
+    return ((param.width > 0 && param.height > 0)
+            && (param.end.x >= 0 && param.end.x < param.width)
+            && (param.end.y >= 0 && param.end.y < param.height)
+            && (param.start.x >= 0 && param.start.x < param.width)
+            && (param.start.y >= 0 && param.start.y < param.height)
+            );
+}
+
+// 节点放入开启列表
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::push_open_list(uint32_t index)
+{
+    states_[index] = generation_;
+    open_list_.push(index, calcul_f_value(g_[index], h_[index]), g_[index]);
+}
+
+// 取出f值最小节点
+template<typename OpenList, typename Coord, typename Cost>
+uint32_t BasicAStar<OpenList, Coord, Cost>::pop_open_list()
+{
+    while (!open_list_.empty())
+    {
+        // 跳过已经关闭的重复节点
+        const uint32_t index = open_list_.pop();
+        if (states_[index] == generation_)
+        {
+            states_[index] = generation_ + 1;
+            return index;
+        }
+    }
+    return kNoParent;
+}
+
+// 回溯生成路径
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::build_path(uint32_t end, bool interpolate, std::vector<Vec2> *out_paths) const
+{
+    uint32_t current = end;
+    while (parent_[current] != kNoParent)
+    {
+        if (!interpolate)
+        {
+            out_paths->push_back(to_pos(current));
+            current = parent_[current];
+            continue;
+        }
+
+        // 跳点与父节点之间是直线或斜线，逐格补全
+        const Vec2 to = to_pos(current);
+        const Vec2 from = to_pos(parent_[current]);
+        const int dx = (to.x > from.x) - (to.x < from.x);
+        const int dy = (to.y > from.y) - (to.y < from.y);
+        Vec2 pos = to;
+        while (!(pos == from))
+        {
+            out_paths->push_back(pos);
+            pos.reset(pos.x - dx, pos.y - dy);
+        }
+        current = parent_[current];
+    }
+    std::reverse(out_paths->begin(), out_paths->end());
+}
+
+// 处理找到节点的情况
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::handle_found_node(uint32_t current, const Vec2 &destination)
+{
+    const uint32_t index = to_index(destination);
+    const Cost g_value = calcul_g_value(current, destination);
+    if (g_value < g_[index])
+    {
+        g_[index] = g_value;
+        parent_[index] = current;
+
+        open_list_.decrease(index, calcul_f_value(g_value, h_[index]), g_value);
+    }
+}
+
+// 处理未找到节点的情况
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::handle_not_found_node(uint32_t current, const Vec2 &destination, const Vec2 &end)
+{
+    const uint32_t index = to_index(destination);
+    parent_[index] = current;
+    h_[index] = calcul_h_value(destination, end);
+    g_[index] = calcul_g_value(current, destination);
+    push_open_list(index);
+}
+
+// 执行寻路操作
+template<typename OpenList, typename Coord, typename Cost>
+auto BasicAStar<OpenList, Coord, Cost>::find(const Params &param) -> std::vector<Vec2>
+{
+    assert(param.can_pass != nullptr);
+    if (param.can_pass == nullptr)
+    {
+        return std::vector<Vec2>();
+    }
+    return find(param, param.can_pass);
+}
+
+// 坐标转换为节点索引
+template<typename OpenList, typename Coord, typename Cost>
+inline uint32_t BasicAStar<OpenList, Coord, Cost>::to_index(const Vec2 &pos) const
+{
+    return uint32_t(pos.y) * width_ + pos.x;
+}
+
+// 节点索引转换为坐标
+template<typename OpenList, typename Coord, typename Cost>
+inline auto BasicAStar<OpenList, Coord, Cost>::to_pos(uint32_t index) const -> Vec2
+{
+    return Vec2(index % width_, index / width_);
+}
+
+// 获取节点状态
+template<typename OpenList, typename Coord, typename Cost>
+inline auto BasicAStar<OpenList, Coord, Cost>::get_state(uint32_t index) const -> NodeState
+{
+    const uint32_t state = states_[index];
+    if (state == generation_)
+    {
+        return IN_OPENLIST;
+    }
+    return state == generation_ + 1 ? IN_CLOSEDLIST : NOTEXIST;
+}
+
+// 计算G值，父节点与当前节点位于同一直线或斜线上，任意角度搜索时为欧氏距离，与H值一样向下取整
+template<typename OpenList, typename Coord, typename Cost>
+inline Cost BasicAStar<OpenList, Coord, Cost>::calcul_g_value(uint32_t parent, const Vec2 &current)
+{
+    const Vec2 from = to_pos(parent);
+    const int64_t dx = std::abs(int64_t(current.x) - from.x);
+    const int64_t dy = std::abs(int64_t(current.y) - from.y);
+    if (mode_ == THETA)
+    {
+        return saturate(g_[parent] + uint64_t(std::sqrt(double(dx * dx + dy * dy)) * step_val_));
+    }
+    const int64_t oblique = std::min(dx, dy);
+    return saturate(g_[parent] + uint64_t(oblique * oblique_val_ + (std::max(dx, dy) - oblique) * step_val_));
+}
+
+// 计算H值
+template<typename OpenList, typename Coord, typename Cost>
+inline Cost BasicAStar<OpenList, Coord, Cost>::calcul_h_value(const Vec2 &current, const Vec2 &end)
+{
+    const int64_t dx = std::abs(int64_t(end.x) - current.x);
+    const int64_t dy = std::abs(int64_t(end.y) - current.y);
+    uint64_t h_value = 0;
+    switch (heuristic_)
+    {
+    case OCTILE:
+        {
+            const int64_t oblique = std::min(dx, dy);
+            h_value = oblique * oblique_val_ + (std::max(dx, dy) - oblique) * step_val_;
+        }
+        break;
+    case EUCLIDEAN:
+        h_value = uint64_t(std::sqrt(double(dx * dx + dy * dy)) * step_val_);
+        break;
+    default:
+        h_value = (dx + dy) * step_val_;
+        break;
+    }
+
+    // 路标给出的下界更紧时使用下界，两者都是一致的，取较大值仍然一致
+    if (use_landmarks_)
+    {
+        const uint32_t end_index = to_index(end);
+        if (end_index != landmark_end_)
+        {
+            landmark_end_ = end_index;
+            landmark_end_distances_.resize(landmarks_->get_count());
+            landmarks_->get_distances(end_index, landmark_end_distances_.data());
+        }
+        h_value = std::max<uint64_t>(h_value, landmarks_->get_lower_bound(to_index(current), landmark_end_distances_.data()));
+    }
+
+    // 加权A*，结果不超过节点表能保存的范围
+    if (weight_ > 1.0f)
+    {
+        h_value = uint64_t(double(h_value) * weight_);
+    }
+    return saturate(h_value);
+}
+
+// 计算开启列表的排序值
+template<typename OpenList, typename Coord, typename Cost>
+inline uint32_t BasicAStar<OpenList, Coord, Cost>::calcul_f_value(Cost g_value, Cost h_value)
+{
+    return uint32_t(std::min(uint64_t(g_value) + h_value, uint64_t(UINT32_MAX)));
+}
+
+// 代价超出范围时取最大值
+template<typename OpenList, typename Coord, typename Cost>
+inline Cost BasicAStar<OpenList, Coord, Cost>::saturate(uint64_t value)
+{
+    return Cost(std::min(value, uint64_t(std::numeric_limits<Cost>::max())));
+}
+
+// 节点是否存在于开启列表
+template<typename OpenList, typename Coord, typename Cost>
+inline bool BasicAStar<OpenList, Coord, Cost>::in_open_list(const Vec2 &pos)
+{
+    return get_state(to_index(pos)) == IN_OPENLIST;
+}
+
+// 节点是否存在于关闭列表
+template<typename OpenList, typename Coord, typename Cost>
+inline bool BasicAStar<OpenList, Coord, Cost>::in_closed_list(const Vec2 &pos)
+{
+    return get_state(to_index(pos)) == IN_CLOSEDLIST;
+}
+
+// 调用可通过性策略
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+inline bool BasicAStar<OpenList, Coord, Cost>::test_pass(GridPolicy &can_pass, const Vec2 &pos)
+{
+    if constexpr (std::is_invocable_r_v<bool, GridPolicy&, const Vec2&>)
+    {
+        return can_pass(pos);
+    }
+    else
+    {
+        return can_pass.can_pass(pos);
+    }
+}
+
+// 是否可到达
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+inline bool BasicAStar<OpenList, Coord, Cost>::can_pass(GridPolicy &can_pass, const Vec2 &pos)
+{
+    return (pos.x >= 0 && pos.x < width_ && pos.y >= 0 && pos.y < height_) ? test_pass(can_pass, pos) : false;
+}
+
+// 当前点是否可到达目标点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+inline bool BasicAStar<OpenList, Coord, Cost>::can_pass(GridPolicy &can_pass, const Vec2 &current, const Vec2 &destination, bool allow_corner)
+{
+    if (destination.x >= 0 && destination.x < width_ && destination.y >= 0 && destination.y < height_)
+    {
+        if (in_closed_list(destination))
+        {
+            return false;
+        }
+
+        if (destination.distance(current) == 1)
+        {
+            return test_pass(can_pass, destination);
+        }
+        else if (allow_corner)
+        {
+            return test_pass(can_pass, destination)
+                    && (this->can_pass(can_pass, Vec2(current.x + destination.x - current.x, current.y))
+                    && this->can_pass(can_pass, Vec2(current.x, current.y + destination.y - current.y)));
+        }
+    }
+    return false;
+}
+
+// 查找附近可通过的节点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+void BasicAStar<OpenList, Coord, Cost>::find_can_pass_nodes(GridPolicy &can_pass, const Vec2 &current, bool corner, std::vector<Vec2> *out_lists)
+{
+    // 地图提供邻域掩码时直接查表
+    if constexpr (requires { { can_pass.get_neighbour_mask(current) } -> std::convertible_to<uint8_t>; })
+    {
+        unsigned int mask = can_pass.get_neighbour_mask(current);
+        if (!corner)
+        {
+            mask &= kStraightMask;
+        }
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            const Vec2 destination(current.x + kNeighbourX[i], current.y + kNeighbourY[i]);
+            if (!in_closed_list(destination))
+            {
+                out_lists->push_back(destination);
+            }
+        }
+        return;
+    }
+
+    Vec2 destination;
+    int row_index = current.y - 1;
+    const int max_row = current.y + 1;
+    const int max_col = current.x + 1;
+
+    if (row_index < 0)
+    {
+        row_index = 0;
+    }
+
+    while (row_index <= max_row)
+    {
+        int col_index = current.x - 1;
+
+        if (col_index < 0)
+        {
+            col_index = 0;
+        }
+
+        while (col_index <= max_col)
+        {
+            destination.reset(col_index, row_index);
+            if (this->can_pass(can_pass, current, destination, corner))
+            {
+                out_lists->push_back(destination);
+            }
+            ++col_index;
+        }
+        ++row_index;
+    }
+}
+
+// 格子是否可通过
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+inline bool BasicAStar<OpenList, Coord, Cost>::walkable(GridPolicy &can_pass, int x, int y)
+{
+    return (x >= 0 && x < int64_t(width_) && y >= 0 && y < int64_t(height_)) ? test_pass(can_pass, Vec2(x, y)) : false;
+}
+
+// 沿方向跳跃查找跳点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::jump(GridPolicy &can_pass, int x, int y, int dx, int dy, const Vec2 &end, bool corner, Vec2 *out_node)
+{
+    while (walkable(can_pass, x, y))
+    {
+        if (int64_t(x) == end.x && int64_t(y) == end.y)
+        {
+            out_node->reset(x, y);
+            return true;
+        }
+
+        if (dx != 0 && dy != 0)
+        {
+            // 斜向移动时，直行方向上存在跳点则当前格子为跳点
+            Vec2 node;
+            if (jump(can_pass, x + dx, y, dx, 0, end, corner, &node)
+                || jump(can_pass, x, y + dy, 0, dy, end, corner, &node))
+            {
+                out_node->reset(x, y);
+                return true;
+            }
+            if (!walkable(can_pass, x + dx, y) || !walkable(can_pass, x, y + dy))
+            {
+                return false;
+            }
+        }
+        else if (dx != 0)
+        {
+            // 侧面的格子刚刚绕过障碍，存在强迫邻居
+            if ((walkable(can_pass, x, y - 1) && !walkable(can_pass, x - dx, y - 1))
+                || (walkable(can_pass, x, y + 1) && !walkable(can_pass, x - dx, y + 1)))
+            {
+                out_node->reset(x, y);
+                return true;
+            }
+        }
+        else
+        {
+            if ((walkable(can_pass, x - 1, y) && !walkable(can_pass, x - 1, y - dy))
+                || (walkable(can_pass, x + 1, y) && !walkable(can_pass, x + 1, y - dy)))
+            {
+                out_node->reset(x, y);
+                return true;
+            }
+
+            // 不允许斜向移动时，纵向移动还要检查横向的跳点
+            Vec2 node;
+            if (!corner && (jump(can_pass, x + 1, y, 1, 0, end, corner, &node)
+                || jump(can_pass, x - 1, y, -1, 0, end, corner, &node)))
+            {
+                out_node->reset(x, y);
+                return true;
+            }
+        }
+
+        x += dx;
+        y += dy;
+    }
+    return false;
+}
+
+// 按预计算的跳跃距离查找跳点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::jump_by_table(GridPolicy &can_pass, const Vec2 &pos, int dx, int dy, const Vec2 &end, bool corner, Vec2 *out_node)
+{
+    static const int kDirections[3][3] = { { 5, 6, 7 }, { 4, -1, 0 }, { 3, 2, 1 } };
+    const int distance = can_pass.get_jump_distance(pos, kDirections[dy + 1][dx + 1], corner);
+    const int reach = distance > 0 ? distance : -distance;
+
+    // 终点方向上的偏移
+    const int gx = end.x - pos.x;
+    const int gy = end.y - pos.y;
+    const bool toward_x = dx == 0 ? gx == 0 : (gx > 0) == (dx > 0) && gx != 0;
+    const bool toward_y = dy == 0 ? gy == 0 : (gy > 0) == (dy > 0) && gy != 0;
+
+    if (dx != 0 && dy != 0)
+    {
+        // 斜向经过与终点同行或同列的格子时停下
+        const int step = std::min(abs(gx), abs(gy));
+        if (toward_x && toward_y && step <= reach)
+        {
+            out_node->reset(pos.x + dx * step, pos.y + dy * step);
+            return true;
+        }
+    }
+    else if (toward_x && toward_y && abs(gx + gy) <= reach)
+    {
+        out_node->reset(end.x, end.y);
+        return true;
+    }
+    else if (!corner && dx == 0 && (gy > 0) == (dy > 0) && gy != 0 && abs(gy) <= reach)
+    {
+        // 四方向规则下纵向经过终点所在的行时停下
+        out_node->reset(pos.x, end.y);
+        return true;
+    }
+
+    if (distance > 0)
+    {
+        out_node->reset(pos.x + dx * distance, pos.y + dy * distance);
+        return true;
+    }
+    return false;
+}
+
+// 查找当前节点的后继跳点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+void BasicAStar<OpenList, Coord, Cost>::find_jump_nodes(GridPolicy &can_pass, uint32_t current, const Vec2 &end, bool corner, std::vector<Vec2> *out_lists)
+{
+    const Vec2 pos = to_pos(current);
+    const int x = pos.x;
+    const int y = pos.y;
+
+    // 裁剪后的搜索方向
+    int count = 0;
+    int directions[8][2];
+    auto add_direction = [&](int dx, int dy)
+    {
+        directions[count][0] = dx;
+        directions[count][1] = dy;
+        ++count;
+    };
+
+    if (parent_[current] == kNoParent)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            const int dx = kNeighbourX[i];
+            const int dy = kNeighbourY[i];
+            if (dx == 0 || dy == 0)
+            {
+                add_direction(dx, dy);
+            }
+            else if (corner && walkable(can_pass, x + dx, y) && walkable(can_pass, x, y + dy))
+            {
+                add_direction(dx, dy);
+            }
+        }
+    }
+    else
+    {
+        const Vec2 parent = to_pos(parent_[current]);
+        const int dx = (int64_t(x) > parent.x) - (int64_t(x) < parent.x);
+        const int dy = (int64_t(y) > parent.y) - (int64_t(y) < parent.y);
+
+        if (dx != 0 && dy != 0)
+        {
+            const bool next_x = walkable(can_pass, x + dx, y);
+            const bool next_y = walkable(can_pass, x, y + dy);
+            if (next_y)
+            {
+                add_direction(0, dy);
+            }
+            if (next_x)
+            {
+                add_direction(dx, 0);
+            }
+            if (next_x && next_y)
+            {
+                add_direction(dx, dy);
+            }
+        }
+        else
+        {
+            // 直行时的自然邻居和两侧的邻居
+            const int side_x = dy;
+            const int side_y = dx;
+            const bool next = walkable(can_pass, x + dx, y + dy);
+            const bool left = walkable(can_pass, x + side_x, y + side_y);
+            const bool right = walkable(can_pass, x - side_x, y - side_y);
+            if (next)
+            {
+                add_direction(dx, dy);
+                if (corner && left)
+                {
+                    add_direction(dx + side_x, dy + side_y);
+                }
+                if (corner && right)
+                {
+                    add_direction(dx - side_x, dy - side_y);
+                }
+            }
+            if (left)
+            {
+                add_direction(side_x, side_y);
+            }
+            if (right)
+            {
+                add_direction(-side_x, -side_y);
+            }
+        }
+    }
+
+    bool use_table = false;
+    if constexpr (requires { can_pass.get_jump_distance(pos, 0, corner); })
+    {
+        use_table = can_pass.has_jump_distances();
+    }
+
+    Vec2 destination;
+    for (int i = 0; i < count; ++i)
+    {
+        const int dx = directions[i][0];
+        const int dy = directions[i][1];
+        bool found = false;
+        if constexpr (requires { can_pass.get_jump_distance(pos, 0, corner); })
+        {
+            if (use_table)
+            {
+                found = jump_by_table(can_pass, pos, dx, dy, end, corner, &destination);
+            }
+        }
+        if (!use_table)
+        {
+            found = jump(can_pass, x + dx, y + dy, dx, dy, end, corner, &destination);
+        }
+        if (found && !in_closed_list(destination))
+        {
+            out_lists->push_back(destination);
+        }
+    }
+}
+
+// 两个格子中心的连线是否只经过可通过的格子
+// 按与连线相交的顺序逐格检查，连线恰好经过格子顶点时要求两侧的格子都可通过
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::line_of_sight(GridPolicy &can_pass, const Vec2 &from, const Vec2 &to)
+{
+    const int nx = int(std::abs(int64_t(to.x) - from.x));
+    const int ny = int(std::abs(int64_t(to.y) - from.y));
+    const int sx = to.x > from.x ? 1 : -1;
+    const int sy = to.y > from.y ? 1 : -1;
+    int x = from.x;
+    int y = from.y;
+    int ix = 0;
+    int iy = 0;
+    while (ix < nx || iy < ny)
+    {
+        const int decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+        if (decision == 0)
+        {
+            if (!walkable(can_pass, x + sx, y) || !walkable(can_pass, x, y + sy))
+            {
+                return false;
+            }
+            x += sx;
+            y += sy;
+            ++ix;
+            ++iy;
+        }
+        else if (decision < 0)
+        {
+            x += sx;
+            ++ix;
+        }
+        else
+        {
+            y += sy;
+            ++iy;
+        }
+
+        if (!walkable(can_pass, x, y))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 父节点不可直视时重新选择父节点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+void BasicAStar<OpenList, Coord, Cost>::update_theta_parent(GridPolicy &can_pass, uint32_t current, bool corner)
+{
+    const Vec2 pos = to_pos(current);
+    uint32_t best_parent = kNoParent;
+    Cost best_g = std::numeric_limits<Cost>::max();
+    for (int i = 0; i < 8; ++i)
+    {
+        const int dx = kNeighbourX[i];
+        const int dy = kNeighbourY[i];
+        const int x = pos.x + dx;
+        const int y = pos.y + dy;
+        if (!walkable(can_pass, x, y) || !in_closed_list(Vec2(x, y)))
+        {
+            continue;
+        }
+        if (dx != 0 && dy != 0 && !(corner && walkable(can_pass, x, pos.y) && walkable(can_pass, pos.x, y)))
+        {
+            continue;
+        }
+
+        const uint32_t neighbour = to_index(Vec2(x, y));
+        const Cost g_value = calcul_g_value(neighbour, pos);
+        if (best_parent == kNoParent || g_value < best_g)
+        {
+            best_g = g_value;
+            best_parent = neighbour;
+        }
+    }
+
+    // 生成当前节点的邻居一定在关闭列表中
+    assert(best_parent != kNoParent);
+    parent_[current] = best_parent;
+    g_[current] = best_g;
+}
+
+// 按连通区域查找离终点最近的可到达格子
+// 第r圈上H值最小的格子为直行r格，圈内已经找到更近的格子时停止
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::find_nearest_reachable(GridPolicy &can_pass, uint32_t component, const Vec2 &end, Vec2 *out_node)
+{
+    bool found = false;
+    Cost best_h = std::numeric_limits<Cost>::max();
+    auto visit = [&](int x, int y)
+    {
+        if (x < 0 || x >= width_ || y < 0 || y >= height_)
+        {
+            return;
+        }
+        const Vec2 pos(x, y);
+        if (can_pass.get_component(pos) != component)
+        {
+            return;
+        }
+        const Cost h_value = calcul_h_value(pos, end);
+        if (!found || h_value < best_h)
+        {
+            found = true;
+            best_h = h_value;
+            *out_node = pos;
+        }
+    };
+
+    const int limit = std::max<int>(width_, height_);
+    for (int r = 1; r < limit; ++r)
+    {
+        if (found && saturate(uint64_t(double(r) * step_val_ * weight_)) > best_h)
+        {
+            break;
+        }
+        for (int x = end.x - r; x <= end.x + r; ++x)
+        {
+            visit(x, end.y - r);
+            visit(x, end.y + r);
+        }
+        for (int y = end.y - r + 1; y <= end.y + r - 1; ++y)
+        {
+            visit(end.x - r, y);
+            visit(end.x + r, y);
+        }
+    }
+    return found;
+}
+
+// 开始寻路
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+void BasicAStar<OpenList, Coord, Cost>::start_search(const Params &param, GridPolicy &can_pass)
+{
+    // 上一次分帧寻路可能没有结束，旧句柄随编号变化失效
+    ++serial_;
+    clear();
+    state_ = NOT_FOUND;
+    closest_ = kNoParent;
+    nearest_ = param.nearest;
+    expanded_ = 0;
+    assert(is_vlid_params(param));
+    if (!is_vlid_params(param))
+    {
+        return;
+    }
+
+    // 初始化
+    init(param);
+    corner_ = param.corner;
+
+    // 路标按8方向计算的代价也是4方向代价的下界，任意角度搜索的代价比格子代价小，下界不成立
+    use_landmarks_ = landmarks_ != nullptr && landmarks_->get_count() > 0
+        && landmarks_->get_width() == param.width && landmarks_->get_height() == param.height
+        && (landmarks_->is_corner() || !param.corner) && param.mode != THETA
+        && landmarks_->get_step_value() == step_val_ && landmarks_->get_oblique_value() == oblique_val_;
+    if constexpr (requires { { can_pass.get_revision() } -> std::convertible_to<uint64_t>; })
+    {
+        use_landmarks_ = use_landmarks_ && can_pass.get_revision() == landmarks_->get_revision();
+    }
+    landmark_end_ = kNoParent;
+    nearby_nodes_.reserve(8);
+
+    // 地图提供连通区域时先排除不可到达的终点，起点不可通过时无法判断，照常搜索
+    end_ = param.end;
+    if constexpr (requires { { can_pass.get_component(end_) } -> std::convertible_to<uint32_t>; })
+    {
+        const uint32_t start_component = can_pass.get_component(param.start);
+        const uint32_t end_component = can_pass.get_component(end_);
+        if (can_pass.has_components() && !(param.start == end_)
+            && (end_component == 0 || (start_component != 0 && start_component != end_component)))
+        {
+            if (!param.nearest)
+            {
+                return;
+            }
+            if (start_component != 0 && !find_nearest_reachable(can_pass, start_component, param.end, &end_))
+            {
+                return;
+            }
+        }
+    }
+
+    // 将起点放入开启列表
+    start_index_ = to_index(param.start);
+    end_index_ = to_index(end_);
+    g_[start_index_] = 0;
+    h_[start_index_] = calcul_h_value(param.start, end_);
+    parent_[start_index_] = kNoParent;
+    push_open_list(start_index_);
+    closest_ = start_index_;
+    state_ = SEARCHING;
+}
+
+// 继续寻路
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::continue_search(GridPolicy &can_pass, size_t budget) -> SearchState
+{
+    for (size_t count = 0; state_ == SEARCHING && count < budget; ++count)
+    {
+        // 找出f值最小节点
+        const uint32_t current = pop_open_list();
+        if (current == kNoParent)
+        {
+            state_ = NOT_FOUND;
+            break;
+        }
+        ++expanded_;
+
+        // 记录离终点最近的节点
+        if (h_[current] < h_[closest_])
+        {
+            closest_ = current;
+        }
+
+        // 任意角度搜索在扩展时才检查父节点是否可直视
+        if (mode_ == THETA && parent_[current] != kNoParent
+            && !line_of_sight(can_pass, to_pos(parent_[current]), to_pos(current)))
+        {
+            update_theta_parent(can_pass, current, corner_);
+        }
+
+        // 是否找到终点
+        if (current == end_index_)
+        {
+            state_ = FOUND;
+            break;
+        }
+
+        // 查找周围可通过节点
+        nearby_nodes_.clear();
+        if (mode_ == JPS)
+        {
+            find_jump_nodes(can_pass, current, end_, corner_, &nearby_nodes_);
+        }
+        else
+        {
+            find_can_pass_nodes(can_pass, to_pos(current), corner_, &nearby_nodes_);
+        }
+
+        // 计算周围节点的估值，任意角度搜索先假设可以直接从父节点到达
+        uint32_t parent = current;
+        if (mode_ == THETA && parent_[current] != kNoParent)
+        {
+            parent = parent_[current];
+        }
+
+        size_t index = 0;
+        const size_t size = nearby_nodes_.size();
+        while (index < size)
+        {
+            if (in_open_list(nearby_nodes_[index]))
+            {
+                handle_found_node(parent, nearby_nodes_[index]);
+            }
+            else
+            {
+                handle_not_found_node(parent, nearby_nodes_[index], end_);
+            }
+            ++index;
+        }
+    }
+
+    if (state_ != SEARCHING)
+    {
+        clear();
+    }
+    return state_;
+}
+
+// 按当前的寻路状态生成路径
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::build_search_path(std::vector<Vec2> *out_paths) const
+{
+    if (state_ == FOUND)
+    {
+        build_path(end_index_, mode_ != THETA, out_paths);
+    }
+    else if (state_ == SEARCHING || nearest_)
+    {
+        // 没有找到终点时退而求其次，走到扩展过的节点中离终点最近的一个
+        if (closest_ != kNoParent && closest_ != start_index_ && closest_ != end_index_)
+        {
+            build_path(closest_, mode_ != THETA, out_paths);
+        }
+    }
+}
+
+// 执行寻路操作
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::find(const Params &param, GridPolicy &&can_pass) -> std::vector<Vec2>
+{
+    std::vector<Vec2> paths;
+    start_search(param, can_pass);
+    continue_search(can_pass, SIZE_MAX);
+    build_search_path(&paths);
+    return paths;
+}
+
+// 分帧寻路
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::find(const Params &param, GridPolicy &&can_pass, size_t budget) -> Search<GridPolicy>
+{
+    Search<GridPolicy> search(this, std::forward<GridPolicy>(can_pass));
+    start_search(param, search.can_pass_);
+    search.serial_ = serial_;
+    search.resume(budget);
+    return search;
+}
+
+// 多终点寻路
+// 到达终点后H值只会变大，开启列表中的旧值仍是下界，取出节点时重新计算，变大则放回开启列表。
+// 限制参与计算的终点数时，新的终点加入后H值可能变小，重建开启列表。
+// 每个时刻的启发函数都是一致的，关闭的节点的G值仍然最优
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy, typename OnGoal>
+void BasicAStar<OpenList, Coord, Cost>::search_goals(const Params &param, const std::vector<Vec2> &ends, GridPolicy &can_pass, OnGoal &&on_goal)
+{
+    // 旧的分帧寻路句柄随编号变化失效
+    ++serial_;
+    clear();
+    state_ = NOT_FOUND;
+    closest_ = kNoParent;
+    nearest_ = false;
+    expanded_ = 0;
+    Params start_param = param;
+    start_param.end = param.start;
+    assert(is_vlid_params(start_param));
+    if (!is_vlid_params(start_param))
+    {
+        return;
+    }
+
+    init(param);
+    mode_ = NORMAL;
+    corner_ = param.corner;
+    use_landmarks_ = false;
+    start_index_ = to_index(param.start);
+    end_index_ = kNoParent;
+
+    // 排除不可通过的终点，地图提供连通区域时同时排除其他区域的终点
+    uint32_t start_component = 0;
+    if constexpr (requires { { can_pass.get_component(param.start) } -> std::convertible_to<uint32_t>; })
+    {
+        start_component = can_pass.has_components() ? can_pass.get_component(param.start) : 0;
+    }
+    goals_.clear();
+    for (size_t i = 0; i < ends.size(); ++i)
+    {
+        const Vec2 &end = ends[i];
+        if (!this->can_pass(can_pass, end))
+        {
+            continue;
+        }
+        if constexpr (requires { { can_pass.get_component(end) } -> std::convertible_to<uint32_t>; })
+        {
+            if (start_component != 0 && can_pass.get_component(end) != start_component)
+            {
+                continue;
+            }
+        }
+        goals_.push_back({ end, to_index(end), uint32_t(i) });
+    }
+    if (goals_.empty())
+    {
+        return;
+    }
+
+    std::stable_sort(goals_.begin(), goals_.end(), [&](const Goal &a, const Goal &b)
+    {
+        return calcul_h_value(param.start, a.pos) < calcul_h_value(param.start, b.pos);
+    });
+    goal_indices_.clear();
+    for (const Goal &goal : goals_)
+    {
+        goal_indices_.push_back(goal.index);
+    }
+    std::sort(goal_indices_.begin(), goal_indices_.end());
+    goal_limit_ = param.goal_limit > 0 ? param.goal_limit : SIZE_MAX;
+
+    g_[start_index_] = 0;
+    h_[start_index_] = calcul_goals_h_value(param.start);
+    parent_[start_index_] = kNoParent;
+    push_open_list(start_index_);
+    goal_opened_.assign(1, start_index_);
+    state_ = SEARCHING;
+
+    while (state_ == SEARCHING)
+    {
+        const uint32_t current = pop_open_list();
+        if (current == kNoParent)
+        {
+            state_ = NOT_FOUND;
+            break;
+        }
+
+        const Vec2 pos = to_pos(current);
+        const Cost h_value = calcul_goals_h_value(pos);
+        if (h_value > h_[current])
+        {
+            h_[current] = h_value;
+            push_open_list(current);
+            goal_opened_.push_back(current);
+            continue;
+        }
+        ++expanded_;
+
+        // 同一个格子可能对应多个终点
+        if (std::binary_search(goal_indices_.begin(), goal_indices_.end(), current))
+        {
+            goal_indices_.erase(std::lower_bound(goal_indices_.begin(), goal_indices_.end(), current));
+            const bool limited = goals_.size() > goal_limit_;
+            for (size_t i = 0; i < goals_.size() && state_ == SEARCHING;)
+            {
+                if (goals_[i].index != current)
+                {
+                    ++i;
+                    continue;
+                }
+                const uint32_t end = goals_[i].end;
+                goals_.erase(goals_.begin() + i);
+                if (!on_goal(size_t(end), current))
+                {
+                    state_ = FOUND;
+                }
+            }
+            if (goals_.empty())
+            {
+                state_ = FOUND;
+            }
+            if (state_ != SEARCHING)
+            {
+                break;
+            }
+            if (limited)
+            {
+                rebuild_goals_open_list();
+            }
+        }
+
+        nearby_nodes_.clear();
+        find_can_pass_nodes(can_pass, pos, corner_, &nearby_nodes_);
+        for (const Vec2 &node : nearby_nodes_)
+        {
+            if (in_open_list(node))
+            {
+                handle_found_node(current, node);
+                continue;
+            }
+            const uint32_t index = to_index(node);
+            parent_[index] = current;
+            h_[index] = calcul_goals_h_value(node);
+            g_[index] = calcul_g_value(current, node);
+            push_open_list(index);
+            goal_opened_.push_back(index);
+        }
+    }
+    clear();
+}
+
+// 计算到多个终点的H值
+template<typename OpenList, typename Coord, typename Cost>
+inline Cost BasicAStar<OpenList, Coord, Cost>::calcul_goals_h_value(const Vec2 &current)
+{
+    Cost h_value = std::numeric_limits<Cost>::max();
+    const size_t count = std::min(goals_.size(), goal_limit_);
+    for (size_t i = 0; i < count; ++i)
+    {
+        h_value = std::min(h_value, calcul_h_value(current, goals_[i].pos));
+    }
+    return h_value;
+}
+
+// 按新的H值重建开启列表
+template<typename OpenList, typename Coord, typename Cost>
+void BasicAStar<OpenList, Coord, Cost>::rebuild_goals_open_list()
+{
+    std::sort(goal_opened_.begin(), goal_opened_.end());
+    goal_opened_.erase(std::unique(goal_opened_.begin(), goal_opened_.end()), goal_opened_.end());
+    open_list_.clear();
+    size_t count = 0;
+    for (uint32_t index : goal_opened_)
+    {
+        if (states_[index] == generation_)
+        {
+            h_[index] = calcul_goals_h_value(to_pos(index));
+            push_open_list(index);
+            goal_opened_[count++] = index;
+        }
+    }
+    goal_opened_.resize(count);
+}
+
+// 多终点寻路，找到代价最小的终点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::find_nearest(const Params &param, const std::vector<Vec2> &ends, GridPolicy &&can_pass, size_t *out_end, std::vector<Vec2> *out_paths)
+{
+    out_paths->clear();
+    bool found = false;
+    search_goals(param, ends, can_pass, [&](size_t end, uint32_t index)
+    {
+        *out_end = end;
+        build_path(index, true, out_paths);
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+// 多终点寻路，找到所有终点
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+size_t BasicAStar<OpenList, Coord, Cost>::find_all(const Params &param, const std::vector<Vec2> &ends, GridPolicy &&can_pass, std::vector<std::vector<Vec2>> *out_paths)
+{
+    out_paths->assign(ends.size(), std::vector<Vec2>());
+    size_t count = 0;
+    search_goals(param, ends, can_pass, [&](size_t end, uint32_t index)
+    {
+        build_path(index, true, &(*out_paths)[end]);
+        ++count;
+        return true;
+    });
+    return count;
+}
+
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+BasicAStar<OpenList, Coord, Cost>::Search<GridPolicy>::Search(BasicAStar *algorithm, GridPolicy &&can_pass)
+    : algorithm_(algorithm)
+    , can_pass_(std::forward<GridPolicy>(can_pass))
+    , serial_(0)
+{
+}
+
+// 继续寻路
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::Search<GridPolicy>::resume(size_t budget) -> SearchState
+{
+    if (!is_current())
+    {
+        return NOT_FOUND;
+    }
+    return algorithm_->continue_search(can_pass_, budget);
+}
+
+// 获取寻路状态
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::Search<GridPolicy>::get_state() const -> SearchState
+{
+    return is_current() ? algorithm_->state_ : NOT_FOUND;
+}
+
+// 获取路径
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+auto BasicAStar<OpenList, Coord, Cost>::Search<GridPolicy>::get_path() const -> std::vector<Vec2>
+{
+    std::vector<Vec2> paths;
+    if (is_current())
+    {
+        algorithm_->build_search_path(&paths);
+    }
+    return paths;
+}
+
+// 句柄是否仍然有效
+template<typename OpenList, typename Coord, typename Cost>
+template<typename GridPolicy>
+bool BasicAStar<OpenList, Coord, Cost>::Search<GridPolicy>::is_current() const
+{
+    return algorithm_ != nullptr && algorithm_->serial_ == serial_;
+}
+
 #endif
@@ -0,0 +1,1515 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "astar.h"
+#include "gridmap.h"
+#include "hpastar.h"
+#include "batchfinder.h"
+#include "pathcache.h"
+#include "dstarlite.h"
+#include "flowfield.h"
+#include "pathservice.h"
+#include "landmarks.h"
+#include "pathdatabase.h"
+#include "subgoalgraph.h"
+#include "gridraster.h"
+#include "navmesh.h"
+
+/**
+ * 测试场景
+ */
+struct Scenario
+{
+    const char*         name;       // 场景名称
+    uint16_t            width;      // 地图宽度
+    uint16_t            height;     // 地图高度
+    int                 density;    // 障碍物比例(百分比)
+    bool                corner;     // 允许拐角
+    uint16_t            span;       // 终点与起点的距离(0表示对角)
+    int                 repeat;     // 重复次数
+};
+
+// 生成地图，起点和终点所在的角落保持可通过
+static std::vector<char> make_map(const Scenario &scenario, unsigned int seed = 20200101)
+{
+    std::vector<char> maps(scenario.width * scenario.height, 0);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 99);
+    for (size_t i = 0; i < maps.size(); ++i)
+    {
+        maps[i] = dist(rng) < scenario.density ? 1 : 0;
+    }
+    maps.front() = 0;
+    maps.back() = 0;
+    return maps;
+}
+
+// 重复执行寻路并输出统计
+template<typename Algorithm, typename Query>
+static void measure(const Scenario &scenario, const char *label, Algorithm &algorithm, Query &&query)
+{
+    // 预热，节点表在之后的寻路中复用
+    query();
+
+    size_t expanded = 0;
+    size_t length = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < scenario.repeat; ++i)
+    {
+        length = query().size();
+        expanded += algorithm.get_expanded_count();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    std::printf("%-24s %-10s path %6zu  expanded %9zu  %8.3f ms/query  %12.0f expansions/s\n",
+                scenario.name,
+                label,
+                length,
+                expanded / scenario.repeat,
+                seconds * 1000.0 / scenario.repeat,
+                expanded / seconds);
+}
+
+static void run(const Scenario &scenario)
+{
+    std::vector<char> maps = make_map(scenario);
+    auto can_pass = [&](const AStar::Vec2 &pos) -> bool
+    {
+        return maps[pos.y * scenario.width + pos.x] == 0;
+    };
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(0, 0);
+    param.end = scenario.span > 0
+        ? AStar::Vec2(scenario.span, scenario.span)
+        : AStar::Vec2(scenario.width - 1, scenario.height - 1);
+    param.can_pass = can_pass;
+
+    AStar algorithm;
+    measure(scenario, "callback", algorithm, [&]() { return algorithm.find(param); });
+    measure(scenario, "template", algorithm, [&]() { return algorithm.find(param, can_pass); });
+
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    measure(scenario, "gridmap", algorithm, [&]() { return algorithm.find(param, grid); });
+    grid.enable_neighbour_masks(true);
+    measure(scenario, "masks", algorithm, [&]() { return algorithm.find(param, grid); });
+
+    AStar::Params weighted_param = param;
+    weighted_param.weight = 1.5f;
+    measure(scenario, "weight 1.5", algorithm, [&]() { return algorithm.find(weighted_param, grid); });
+
+    BasicAStar<RadixHeap> radix;
+    measure(scenario, "radix", radix, [&]() { return radix.find(param, grid); });
+
+    AStar::Params jps_param = param;
+    jps_param.mode = AStar::JPS;
+    measure(scenario, "jps", algorithm, [&]() { return algorithm.find(jps_param, grid); });
+    grid.enable_jump_distances(true);
+    measure(scenario, "jps+", algorithm, [&]() { return algorithm.find(jps_param, grid); });
+    measure(scenario, "jps+ radix", radix, [&]() { return radix.find(jps_param, grid); });
+
+    AStar::Params theta_param = param;
+    theta_param.mode = AStar::THETA;
+    measure(scenario, "theta", algorithm, [&]() { return algorithm.find(theta_param, grid); });
+
+    // 分层寻路，单独输出建图时间
+    HPAStar hpa;
+    auto begin = std::chrono::steady_clock::now();
+    hpa.build(grid, scenario.corner);
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s nodes %zu  build %.1f ms\n",
+                scenario.name,
+                "hpa build",
+                hpa.get_node_count(),
+                std::chrono::duration<double>(end - begin).count() * 1000.0);
+    measure(scenario, "hpa", hpa, [&]() { return hpa.find(param.start, param.end); });
+}
+
+// 随机生成起点和终点都可通过的请求
+static std::vector<BatchFinder::Query> make_queries(const GridMap &grid, int count, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist_x(0, grid.get_width() - 1);
+    std::uniform_int_distribution<int> dist_y(0, grid.get_height() - 1);
+    auto random_cell = [&]()
+    {
+        while (true)
+        {
+            AStar::Vec2 pos(dist_x(rng), dist_y(rng));
+            if (grid.can_pass(pos))
+            {
+                return pos;
+            }
+        }
+    };
+
+    std::vector<BatchFinder::Query> queries(count);
+    for (BatchFinder::Query &query : queries)
+    {
+        query.start = random_cell();
+        query.end = random_cell();
+    }
+    return queries;
+}
+
+// 批量寻路，比较不同线程数，并检查结果与单线程一致
+static void run_batch(const Scenario &scenario, int count)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    std::vector<BatchFinder::Query> queries = make_queries(grid, count, 20200102);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+
+    std::vector<BatchFinder::Path> expected;
+    const unsigned int thread_counts[] = { 1, 2, 4, std::thread::hardware_concurrency() };
+    for (unsigned int threads : thread_counts)
+    {
+        BatchFinder finder(threads);
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<BatchFinder::Path> paths = finder.find_batch(param, queries, grid);
+        auto end = std::chrono::steady_clock::now();
+        if (expected.empty())
+        {
+            expected = paths;
+        }
+
+        char label[32];
+        std::snprintf(label, sizeof(label), "batch x%zu", finder.get_thread_count());
+        std::printf("%-24s %-10s queries %d  %8.3f ms/batch  %s\n",
+                    scenario.name,
+                    label,
+                    count,
+                    std::chrono::duration<double>(end - begin).count() * 1000.0,
+                    paths == expected ? "same" : "DIFFERENT");
+    }
+}
+
+// 异步寻路服务，每个请求提交后立即取消上一个请求的一半，模拟 Agent 重新规划
+// 提交线程只统计提交和回调的耗时，并检查完成的结果与同步寻路一致
+static void run_service(const Scenario &scenario, int count)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    std::vector<BatchFinder::Query> queries = make_queries(grid, count, 20200102);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+
+    std::vector<PathService::Path> paths(count);
+    std::vector<bool> done(count, false);
+    PathService service(grid, std::max(1u, std::thread::hardware_concurrency()));
+    PathService::Ticket previous;
+    double submit_seconds = 0.0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        auto submit_begin = std::chrono::steady_clock::now();
+        AStar::Params query = param;
+        query.start = queries[i].start;
+        query.end = queries[i].end;
+        if (i % 2 == 1)
+        {
+            previous.cancel();
+        }
+        previous = service.submit(query, i % 3, [&paths, &done, i](PathService::Path &&path)
+        {
+            paths[i] = std::move(path);
+            done[i] = true;
+        });
+        service.poll();
+        submit_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submit_begin).count();
+    }
+
+    const int expected = count - count / 2;
+    int completed = 0;
+    while (completed < expected)
+    {
+        service.poll();
+        completed = int(std::count(done.begin(), done.end(), true));
+        std::this_thread::yield();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    AStar algorithm;
+    bool same = true;
+    for (int i = 0; i < count; ++i)
+    {
+        if (done[i])
+        {
+            AStar::Params query = param;
+            query.start = queries[i].start;
+            query.end = queries[i].end;
+            same = same && paths[i] == algorithm.find(query, grid);
+        }
+    }
+
+    char label[32];
+    std::snprintf(label, sizeof(label), "service x%zu", service.get_thread_count());
+    std::printf("%-24s %-10s queries %d  dropped %zu  %8.3f ms total  %8.4f ms/submit  %s\n",
+                scenario.name,
+                label,
+                count,
+                service.get_dropped_count(),
+                std::chrono::duration<double>(end - begin).count() * 1000.0,
+                submit_seconds * 1000.0 / count,
+                same ? "same" : "DIFFERENT");
+}
+
+// 路径缓存，请求从少量起点终点中重复选取，中途修改一次地图
+static void run_cache(const Scenario &scenario, int distinct, int count)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    std::vector<BatchFinder::Query> queries = make_queries(grid, distinct, 20200103);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+
+    AStar algorithm;
+    PathCache cache;
+    std::mt19937 rng(20200104);
+    std::uniform_int_distribution<int> pick(0, distinct - 1);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        if (i == count / 2)
+        {
+            const AStar::Vec2 pos(scenario.width / 2, scenario.height / 2);
+            grid.set_pass(pos, !grid.can_pass(pos));
+        }
+        const BatchFinder::Query &query = queries[pick(rng)];
+        param.start = query.start;
+        param.end = query.end;
+        cache.find(algorithm, param, grid);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::printf("%-24s %-10s queries %d  hit %zu  miss %zu  %zu bytes  %8.3f ms/query\n",
+                scenario.name,
+                "cache",
+                count,
+                cache.get_hit_count(),
+                cache.get_miss_count(),
+                cache.get_memory_usage(),
+                std::chrono::duration<double>(end - begin).count() * 1000.0 / count);
+
+    // 同一缓存混用不同的搜索参数，结果应与直接寻路相同
+    std::vector<AStar::Params> variants(4, param);
+    variants[1].mode = AStar::JPS;
+    variants[2].mode = AStar::THETA;
+    variants[3].weight = 1.5f;
+    const int mixed = std::min(distinct, 8);
+    std::vector<PathCache::Path> expected;
+    for (int i = 0; i < mixed; ++i)
+    {
+        for (AStar::Params &variant : variants)
+        {
+            variant.start = queries[i].start;
+            variant.end = queries[i].end;
+            expected.push_back(algorithm.find(variant, grid));
+        }
+    }
+
+    PathCache mixed_cache;
+    std::uniform_int_distribution<int> pick_mixed(0, int(expected.size()) - 1);
+    size_t different = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const int index = pick_mixed(rng);
+        AStar::Params &variant = variants[index % variants.size()];
+        variant.start = queries[index / variants.size()].start;
+        variant.end = queries[index / variants.size()].end;
+        different += mixed_cache.find(algorithm, variant, grid) != expected[index];
+    }
+    std::printf("%-24s %-10s queries %d  hit %zu  miss %zu  %s\n",
+                scenario.name,
+                "cache mix",
+                count,
+                mixed_cache.get_hit_count(),
+                mixed_cache.get_miss_count(),
+                different == 0 ? "same" : "DIFFERENT");
+}
+
+// 增量寻路，每轮在当前路径上放置少量障碍后重新寻路，与完整搜索比较
+static void run_replan(const Scenario &scenario, int rounds, int cells)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(0, 0);
+    param.end = AStar::Vec2(scenario.width - 1, scenario.height - 1);
+
+    DStarLite planner;
+    auto begin = std::chrono::steady_clock::now();
+    planner.init(grid, param.start, param.end, param.corner);
+    std::vector<AStar::Vec2> path = planner.find();
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s path %6zu  expanded %9zu  %8.3f ms\n",
+                scenario.name,
+                "d* init",
+                path.size(),
+                planner.get_expanded_count(),
+                std::chrono::duration<double>(end - begin).count() * 1000.0);
+
+    AStar algorithm;
+    std::mt19937 rng(20200105);
+    double replan_seconds = 0;
+    double full_seconds = 0;
+    size_t replan_expanded = 0;
+    size_t full_expanded = 0;
+    for (int round = 0; round < rounds && !path.empty(); ++round)
+    {
+        // 在路径中段随机挡住几个格子
+        std::vector<AStar::Vec2> changed;
+        std::uniform_int_distribution<size_t> pick(path.size() / 4, path.size() * 3 / 4);
+        for (int i = 0; i < cells; ++i)
+        {
+            const AStar::Vec2 pos = path[pick(rng)];
+            grid.set_pass(pos, false);
+            changed.push_back(pos);
+        }
+
+        begin = std::chrono::steady_clock::now();
+        planner.update(changed);
+        path = planner.find();
+        end = std::chrono::steady_clock::now();
+        replan_seconds += std::chrono::duration<double>(end - begin).count();
+        replan_expanded += planner.get_expanded_count();
+
+        begin = std::chrono::steady_clock::now();
+        std::vector<AStar::Vec2> full = algorithm.find(param, grid);
+        end = std::chrono::steady_clock::now();
+        full_seconds += std::chrono::duration<double>(end - begin).count();
+        full_expanded += algorithm.get_expanded_count();
+    }
+
+    std::printf("%-24s %-10s rounds %d  expanded %9zu  %8.3f ms/replan\n",
+                scenario.name, "d* replan", rounds, replan_expanded / rounds, replan_seconds * 1000.0 / rounds);
+    std::printf("%-24s %-10s rounds %d  expanded %9zu  %8.3f ms/replan\n",
+                scenario.name, "full", rounds, full_expanded / rounds, full_seconds * 1000.0 / rounds);
+}
+
+// 多个 Agent 前往同一目标，比较逐个寻路和共用流场，以及流场的增量更新
+static void run_flow(const Scenario &scenario, int agents, int rounds, int cells)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    std::vector<BatchFinder::Query> queries = make_queries(grid, agents, 20200106);
+    const AStar::Vec2 goal = queries.front().end;
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.end = goal;
+
+    AStar algorithm;
+    size_t expanded = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (const BatchFinder::Query &query : queries)
+    {
+        param.start = query.start;
+        algorithm.find(param, grid);
+        expanded += algorithm.get_expanded_count();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s agents %d  expanded %9zu  %8.3f ms\n",
+                scenario.name, "per agent", agents, expanded,
+                std::chrono::duration<double>(end - begin).count() * 1000.0);
+
+    FlowField flow;
+    begin = std::chrono::steady_clock::now();
+    flow.build(grid, goal, scenario.corner);
+    end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s agents %d  expanded %9zu  %8.3f ms\n",
+                scenario.name, "flow field", agents, flow.get_expanded_count(),
+                std::chrono::duration<double>(end - begin).count() * 1000.0);
+
+    // 每轮翻转几个格子，增量更新与重新生成比较
+    std::mt19937 rng(20200107);
+    std::uniform_int_distribution<int> dist_x(0, scenario.width - 1);
+    std::uniform_int_distribution<int> dist_y(0, scenario.height - 1);
+    size_t update_expanded = 0;
+    size_t build_expanded = 0;
+    double update_seconds = 0.0;
+    double build_seconds = 0.0;
+    bool same = true;
+    FlowField rebuilt;
+    for (int round = 0; round < rounds; ++round)
+    {
+        std::vector<AStar::Vec2> changed;
+        for (int i = 0; i < cells; ++i)
+        {
+            const AStar::Vec2 pos(dist_x(rng), dist_y(rng));
+            grid.set_pass(pos, !grid.can_pass(pos));
+            changed.push_back(pos);
+        }
+
+        begin = std::chrono::steady_clock::now();
+        flow.update(changed);
+        end = std::chrono::steady_clock::now();
+        update_seconds += std::chrono::duration<double>(end - begin).count();
+        update_expanded += flow.get_expanded_count();
+
+        begin = std::chrono::steady_clock::now();
+        rebuilt.build(grid, goal, scenario.corner);
+        end = std::chrono::steady_clock::now();
+        build_seconds += std::chrono::duration<double>(end - begin).count();
+        build_expanded += rebuilt.get_expanded_count();
+
+        for (const BatchFinder::Query &query : queries)
+        {
+            same = same && flow.get_distance(query.start) == rebuilt.get_distance(query.start);
+        }
+    }
+    std::printf("%-24s %-10s rounds %d  expanded %9zu  %8.3f ms/update  %s\n",
+                scenario.name, "flow upd", rounds, update_expanded / rounds, update_seconds * 1000.0 / rounds,
+                same ? "same" : "DIFFERENT");
+    std::printf("%-24s %-10s rounds %d  expanded %9zu  %8.3f ms/update\n",
+                scenario.name, "flow build", rounds, build_expanded / rounds, build_seconds * 1000.0 / rounds);
+}
+
+// 终点被围住，比较完整搜索与连通区域直接排除，以及最近点回退
+static void run_unreachable(const Scenario &scenario)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(0, 0);
+    param.end = AStar::Vec2(scenario.width - 1, scenario.height - 1);
+    grid.set_pass(AStar::Vec2(param.end.x - 1, param.end.y), false);
+    grid.set_pass(AStar::Vec2(param.end.x, param.end.y - 1), false);
+    grid.set_pass(AStar::Vec2(param.end.x - 1, param.end.y - 1), false);
+
+    AStar algorithm;
+    measure(scenario, "walled", algorithm, [&]() { return algorithm.find(param, grid); });
+    grid.enable_components(true);
+    measure(scenario, "components", algorithm, [&]() { return algorithm.find(param, grid); });
+
+    AStar::Params nearest_param = param;
+    nearest_param.nearest = true;
+    measure(scenario, "nearest", algorithm, [&]() { return algorithm.find(nearest_param, grid); });
+}
+
+// 长路径的代价超出16位时比较两种节点表
+static void run_wide(const Scenario &scenario)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(0, 0);
+    param.end = AStar::Vec2(scenario.width - 1, scenario.height - 1);
+
+    AStar compact;
+    measure(scenario, "compact", compact, [&]() { return compact.find(param, grid); });
+    WideAStar wide;
+    measure(scenario, "wide", wide, [&]() { return wide.find(param, grid); });
+}
+
+// 分帧寻路，统计每帧的最长耗时，与一次完成的寻路比较
+static void run_sliced(const Scenario &scenario, size_t budget)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(0, 0);
+    param.end = AStar::Vec2(scenario.width - 1, scenario.height - 1);
+
+    AStar algorithm;
+    measure(scenario, "blocking", algorithm, [&]() { return algorithm.find(param, grid); });
+
+    int frames = 0;
+    double total = 0.0;
+    double longest = 0.0;
+    AStar::Search<GridMap&> search = algorithm.find(param, grid, budget);
+    while (search.get_state() == AStar::SEARCHING)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        search.resume(budget);
+        auto end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        total += ms;
+        longest = std::max(longest, ms);
+        ++frames;
+    }
+
+    char label[32];
+    std::snprintf(label, sizeof(label), "sliced %zu", budget);
+    std::printf("%-24s %-10s path %6zu  frames %d  %8.3f ms total  %8.3f ms/frame max\n",
+                scenario.name,
+                label,
+                search.get_path().size(),
+                frames,
+                total,
+                longest);
+}
+
+// 生成迷宫，墙和通道各占一格，任意两个通道格子之间只有一条路
+static std::vector<char> make_maze(const Scenario &scenario)
+{
+    const int width = scenario.width;
+    const int height = scenario.height;
+    std::vector<char> maps(width * height, 1);
+    std::mt19937 rng(20200103);
+    std::vector<std::pair<int, int>> stack = { { 1, 1 } };
+    maps[width + 1] = 0;
+    while (!stack.empty())
+    {
+        const auto [x, y] = stack.back();
+        int directions[4] = { 0, 2, 4, 6 };
+        std::shuffle(directions, directions + 4, rng);
+        bool moved = false;
+        for (int direction : directions)
+        {
+            const int nx = x + AStar::kNeighbourX[direction] * 2;
+            const int ny = y + AStar::kNeighbourY[direction] * 2;
+            if (nx > 0 && nx < width - 1 && ny > 0 && ny < height - 1 && maps[ny * width + nx] != 0)
+            {
+                maps[(y + ny) / 2 * width + (x + nx) / 2] = 0;
+                maps[ny * width + nx] = 0;
+                stack.emplace_back(nx, ny);
+                moved = true;
+                break;
+            }
+        }
+        if (!moved)
+        {
+            stack.pop_back();
+        }
+    }
+    return maps;
+}
+
+// 迷宫中比较几何启发函数与 ALT 路标，以及路标的生成和载入耗时
+// 迷宫路径很长，代价超出16位，使用 WideAStar
+static void run_landmarks(const Scenario &scenario, int count)
+{
+    std::vector<char> maps = make_maze(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(1, 1);
+    param.end = AStar::Vec2(scenario.width - 2, scenario.height - 2);
+
+    WideAStar algorithm;
+    measure(scenario, "geometric", algorithm, [&]() { return algorithm.find(param, grid); });
+
+    Landmarks landmarks;
+    auto begin = std::chrono::steady_clock::now();
+    landmarks.build(grid, count, true);
+    auto end = std::chrono::steady_clock::now();
+    const double build_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    const char *filename = "astar_bench_landmarks.bin";
+    landmarks.save(filename);
+    Landmarks loaded;
+    begin = std::chrono::steady_clock::now();
+    const bool ok = loaded.load(filename, grid);
+    end = std::chrono::steady_clock::now();
+    const double load_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::remove(filename);
+
+    std::printf("%-24s %-10s landmarks %d  %zu bytes  build %.1f ms  load %.1f ms  %s\n",
+                scenario.name,
+                "alt",
+                loaded.get_count(),
+                loaded.get_memory_usage(),
+                build_ms,
+                load_ms,
+                ok ? "loaded" : "LOAD FAILED");
+
+    algorithm.set_landmarks(&loaded);
+    measure(scenario, "landmarks", algorithm, [&]() { return algorithm.find(param, grid); });
+}
+
+// 路径代价，直行为10，斜向为14
+static long path_cost(const AStar::Vec2 &start, const std::vector<AStar::Vec2> &path)
+{
+    long cost = 0;
+    AStar::Vec2 from = start;
+    for (const AStar::Vec2 &to : path)
+    {
+        cost += (from.x != to.x && from.y != to.y) ? AStar::kObliqueValue : AStar::kStepValue;
+        from = to;
+    }
+    return cost;
+}
+
+// 参考用的 Dijkstra，代价和拐角规则与 AStar 相同，返回起点到每个格子的最小代价，不可到达为-1
+static std::vector<long> reference_costs(const GridMap &grid, const AStar::Vec2 &start, bool corner)
+{
+    const int width = grid.get_width();
+    std::vector<long> costs(size_t(width) * grid.get_height(), -1);
+    typedef std::pair<long, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    costs[start.y * width + start.x] = 0;
+    queue.push({ 0, start.y * width + start.x });
+    while (!queue.empty())
+    {
+        const Item item = queue.top();
+        queue.pop();
+        if (item.first != costs[item.second])
+        {
+            continue;
+        }
+
+        const int x = item.second % width;
+        const int y = item.second / width;
+        for (int i = 0; i < 8; ++i)
+        {
+            const int dx = AStar::kNeighbourX[i];
+            const int dy = AStar::kNeighbourY[i];
+            const bool oblique = dx != 0 && dy != 0;
+            if (!grid.can_pass(x + dx, y + dy)
+                || (oblique && (!corner || !grid.can_pass(x + dx, y) || !grid.can_pass(x, y + dy))))
+            {
+                continue;
+            }
+
+            const int next = (y + dy) * width + x + dx;
+            const long cost = item.first + (oblique ? AStar::kObliqueValue : AStar::kStepValue);
+            if (costs[next] < 0 || cost < costs[next])
+            {
+                costs[next] = cost;
+                queue.push({ cost, next });
+            }
+        }
+    }
+    return costs;
+}
+
+// 检查路径每一步都是合法的移动并到达终点，返回路径代价，找不到路径为-1，路径不合法为-2
+static long checked_cost(const GridMap &grid, const AStar::Vec2 &start, const AStar::Vec2 &end, bool corner, const std::vector<AStar::Vec2> &path)
+{
+    if (path.empty())
+    {
+        return start == end ? 0 : -1;
+    }
+    AStar::Vec2 from = start;
+    for (const AStar::Vec2 &to : path)
+    {
+        const int dx = to.x - from.x;
+        const int dy = to.y - from.y;
+        if (std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0) || !grid.can_pass(to)
+            || (dx != 0 && dy != 0 && (!corner || !grid.can_pass(to.x, from.y) || !grid.can_pass(from.x, to.y))))
+        {
+            return -2;
+        }
+        from = to;
+    }
+    return path.back() == end ? path_cost(start, path) : -2;
+}
+
+// 两个格子中心之间的线段经过的格子是否都可通过，只在顶点处接触的格子也要求可通过
+static bool segment_clear(const GridMap &grid, const AStar::Vec2 &from, const AStar::Vec2 &to)
+{
+    // 坐标放大两倍，格子边界落在奇数上，判断全部使用整数
+    const long dx = 2 * (long(to.x) - from.x);
+    const long dy = 2 * (long(to.y) - from.y);
+    for (int y = std::min(from.y, to.y); y <= std::max(from.y, to.y); ++y)
+    {
+        for (int x = std::min(from.x, to.x); x <= std::max(from.x, to.x); ++x)
+        {
+            int above = 0;
+            int below = 0;
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                const long cx = 2 * (long(x) - from.x) + (corner & 1 ? 1 : -1);
+                const long cy = 2 * (long(y) - from.y) + (corner & 2 ? 1 : -1);
+                const long side = dx * cy - dy * cx;
+                above += side > 0;
+                below += side < 0;
+            }
+            if (above < 4 && below < 4 && !grid.can_pass(x, y))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 连通区域编号是否与重新按四方向填充的结果一一对应，不可通过的格子为0
+static bool same_components(const GridMap &grid)
+{
+    const int width = grid.get_width();
+    const int height = grid.get_height();
+    std::vector<uint32_t> labels(size_t(width) * height, 0);
+    std::vector<uint32_t> forward(1, 0);        // 填充编号对应的区域编号
+    std::vector<uint32_t> backward;             // 区域编号对应的填充编号
+    std::vector<int> stack;
+    for (int start = 0; start < width * height; ++start)
+    {
+        const AStar::Vec2 pos(start % width, start / width);
+        if (labels[start] != 0 || !grid.can_pass(pos))
+        {
+            if (!grid.can_pass(pos) && grid.get_component(pos) != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        const uint32_t label = uint32_t(forward.size());
+        forward.push_back(grid.get_component(pos));
+        labels[start] = label;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            const int index = stack.back();
+            stack.pop_back();
+            const int x = index % width;
+            const int y = index / width;
+            for (int i = 0; i < 8; i += 2)
+            {
+                const int nx = x + AStar::kNeighbourX[i];
+                const int ny = y + AStar::kNeighbourY[i];
+                if (grid.can_pass(nx, ny) && labels[ny * width + nx] == 0)
+                {
+                    labels[ny * width + nx] = label;
+                    stack.push_back(ny * width + nx);
+                }
+            }
+        }
+    }
+
+    for (int index = 0; index < width * height; ++index)
+    {
+        const uint32_t component = grid.get_component(AStar::Vec2(index % width, index / width));
+        if (labels[index] == 0)
+        {
+            continue;
+        }
+        if (component == 0 || component != forward[labels[index]])
+        {
+            return false;
+        }
+        if (component >= backward.size())
+        {
+            backward.resize(component + 1, 0);
+        }
+        if (backward[component] != 0 && backward[component] != labels[index])
+        {
+            return false;
+        }
+        backward[component] = labels[index];
+    }
+    return true;
+}
+
+// 路径数据库的生成、载入和查询耗时，与 AStar 比较查询耗时并检查代价一致
+static void run_database(const Scenario &scenario, int count)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    std::vector<BatchFinder::Query> queries = make_queries(grid, count, 20200103);
+
+    PathDatabase database;
+    auto begin = std::chrono::steady_clock::now();
+    database.build(grid, scenario.corner);
+    auto end = std::chrono::steady_clock::now();
+    const double build_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    const char *filename = "astar_bench_database.bin";
+    database.save(filename);
+    PathDatabase loaded;
+    begin = std::chrono::steady_clock::now();
+    const bool ok = loaded.load(filename, grid);
+    end = std::chrono::steady_clock::now();
+    const double load_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::remove(filename);
+
+    std::printf("%-24s %-10s runs %zu  %zu bytes  build %.1f ms  load %.3f ms  %s\n",
+                scenario.name,
+                "database",
+                loaded.get_run_count(),
+                loaded.get_memory_usage(),
+                build_ms,
+                load_ms,
+                ok ? "loaded" : "LOAD FAILED");
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+
+    AStar algorithm;
+    std::vector<long> costs;
+    begin = std::chrono::steady_clock::now();
+    for (const BatchFinder::Query &query : queries)
+    {
+        param.start = query.start;
+        param.end = query.end;
+        costs.push_back(path_cost(query.start, algorithm.find(param, grid)));
+    }
+    end = std::chrono::steady_clock::now();
+    const double astar_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    size_t different = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        different += path_cost(queries[i].start, loaded.find(queries[i].start, queries[i].end)) != costs[i];
+    }
+    end = std::chrono::steady_clock::now();
+    const double database_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::printf("%-24s %-10s queries %d  astar %8.4f ms/query  database %8.4f ms/query  %s\n",
+                scenario.name,
+                "database",
+                count,
+                astar_ms / count,
+                database_ms / count,
+                different == 0 ? "same cost" : "DIFFERENT");
+}
+
+// 生成房间和走廊，房间之间的墙上各开一扇门，房间内散布方柱
+static std::vector<char> make_rooms(const Scenario &scenario, int room_size)
+{
+    const int width = scenario.width;
+    const int height = scenario.height;
+    std::vector<char> maps(width * height, 0);
+    std::mt19937 rng(20200104);
+    std::uniform_int_distribution<int> door(2, room_size - 5);
+    std::uniform_int_distribution<int> pillar(2, room_size - 4);
+    for (int top = 0; top < height; top += room_size)
+    {
+        for (int left = 0; left < width; left += room_size)
+        {
+            const int x_door = left + door(rng);
+            const int y_door = top + door(rng);
+            for (int i = 0; i < room_size; ++i)
+            {
+                if ((left + i < x_door || left + i > x_door + 2) && left + i < width)
+                {
+                    maps[top * width + left + i] = 1;
+                }
+                if ((top + i < y_door || top + i > y_door + 2) && top + i < height)
+                {
+                    maps[(top + i) * width + left] = 1;
+                }
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                const int x = left + pillar(rng);
+                const int y = top + pillar(rng);
+                for (int k = 0; k < 4; ++k)
+                {
+                    if (x + (k & 1) < width && y + (k >> 1) < height)
+                    {
+                        maps[(y + (k >> 1)) * width + x + (k & 1)] = 1;
+                    }
+                }
+            }
+        }
+    }
+    maps[width + 1] = 0;
+    maps[(height - 2) * width + width - 2] = 0;
+    return maps;
+}
+
+// 房间和走廊的地图上比较 AStar、JPS 与子目标图，只搜索子目标图和细化为格子路径分别计时，
+// 并检查随机请求的路径代价一致
+static void run_subgoal(const Scenario &scenario, int room_size, int count)
+{
+    std::vector<char> maps = make_rooms(scenario, room_size);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    grid.enable_jump_distances(true);
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = true;
+    param.start = AStar::Vec2(1, 1);
+    param.end = AStar::Vec2(scenario.width - 2, scenario.height - 2);
+
+    AStar algorithm;
+    measure(scenario, "normal", algorithm, [&]() { return algorithm.find(param, grid); });
+    AStar::Params jps_param = param;
+    jps_param.mode = AStar::JPS;
+    measure(scenario, "jps+", algorithm, [&]() { return algorithm.find(jps_param, grid); });
+
+    SubgoalGraph graph;
+    auto begin = std::chrono::steady_clock::now();
+    graph.build(grid);
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s subgoals %zu  edges %zu  %zu bytes  build %.1f ms\n",
+                scenario.name,
+                "subgoal",
+                graph.get_node_count(),
+                graph.get_edge_count(),
+                graph.get_memory_usage(),
+                std::chrono::duration<double, std::milli>(end - begin).count());
+
+    std::vector<AStar::Vec2> nodes;
+    measure(scenario, "subgoals", graph, [&]()
+    {
+        graph.find_abstract(param.start, param.end, &nodes);
+        return nodes;
+    });
+    measure(scenario, "refined", graph, [&]() { return graph.find(param.start, param.end); });
+
+    size_t different = 0;
+    for (const BatchFinder::Query &query : make_queries(grid, count, 20200105))
+    {
+        param.start = query.start;
+        param.end = query.end;
+        different += path_cost(query.start, algorithm.find(param, grid)) != path_cost(query.start, graph.find(query.start, query.end));
+    }
+    std::printf("%-24s %-10s queries %d  %s\n", scenario.name, "subgoal", count, different == 0 ? "same cost" : "DIFFERENT");
+}
+
+// 路径在世界坐标中的长度
+static double path_length(float x, float y, const std::vector<NavMesh::Point> &waypoints)
+{
+    double length = 0.0;
+    for (const NavMesh::Point &point : waypoints)
+    {
+        length += std::hypot(point.x - x, point.y - y);
+        x = point.x;
+        y = point.y;
+    }
+    return length;
+}
+
+// 随机矩形障碍物的世界中比较格子 AStar 与导航网格，格子边长为1，
+// 统计随机请求的耗时、扩展数和路径长度，以及新增障碍物时局部重建的耗时
+static void run_navmesh(const Scenario &scenario, int obstacles, float tile_size, int count)
+{
+    std::mt19937 rng(20200106);
+    std::uniform_real_distribution<float> dist_x(0.0f, scenario.width);
+    std::uniform_real_distribution<float> dist_y(0.0f, scenario.height);
+    std::uniform_real_distribution<float> dist_size(2.0f, 20.0f);
+
+    GridRaster raster;
+    raster.set_transform(0.5f, 0.5f, 1.0f);
+    NavMesh navmesh;
+    navmesh.set_bounds(0.0f, 0.0f, scenario.width, scenario.height, tile_size);
+    for (int i = 0; i < obstacles; ++i)
+    {
+        const float x = dist_x(rng);
+        const float y = dist_y(rng);
+        const float w = dist_size(rng);
+        const float h = dist_size(rng);
+        std::vector<NavMesh::Point> polygon = { { x, y }, { x + w, y }, { x + w, y + h }, { x, y + h } };
+        raster.add_polygon({ { x, y }, { x + w, y }, { x + w, y + h }, { x, y + h } });
+        navmesh.add_polygon(std::move(polygon));
+    }
+
+    GridMap grid(scenario.width, scenario.height);
+    raster.build(grid, scenario.width, scenario.height);
+    auto begin = std::chrono::steady_clock::now();
+    navmesh.build();
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s tiles %zu  triangles %zu  build %.1f ms\n",
+                scenario.name,
+                "navmesh",
+                navmesh.get_tile_count(),
+                navmesh.get_triangle_count(),
+                std::chrono::duration<double, std::milli>(end - begin).count());
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = true;
+
+    AStar algorithm;
+    std::vector<NavMesh::Point> waypoints;
+    std::vector<BatchFinder::Query> queries = make_queries(grid, count, 20200107);
+    size_t grid_expanded = 0;
+    size_t mesh_expanded = 0;
+    size_t grid_found = 0;
+    size_t mesh_found = 0;
+    double grid_length = 0.0;
+    double mesh_length = 0.0;
+    double grid_ms = 0.0;
+    double mesh_ms = 0.0;
+    for (const BatchFinder::Query &query : queries)
+    {
+        param.start = query.start;
+        param.end = query.end;
+        begin = std::chrono::steady_clock::now();
+        const std::vector<AStar::Vec2> paths = algorithm.find(param, grid);
+        end = std::chrono::steady_clock::now();
+        grid_ms += std::chrono::duration<double, std::milli>(end - begin).count();
+        grid_expanded += algorithm.get_expanded_count();
+
+        const NavMesh::Point start = { query.start.x + 0.5f, query.start.y + 0.5f };
+        const NavMesh::Point goal = { query.end.x + 0.5f, query.end.y + 0.5f };
+        begin = std::chrono::steady_clock::now();
+        const bool found = navmesh.find(start, goal, 0.0f, &waypoints);
+        end = std::chrono::steady_clock::now();
+        mesh_ms += std::chrono::duration<double, std::milli>(end - begin).count();
+        mesh_expanded += navmesh.get_expanded_count();
+
+        // 只统计两者都找到的路径长度
+        if (!paths.empty() && found)
+        {
+            grid_length += path_cost(query.start, paths) / double(AStar::kStepValue);
+            mesh_length += path_length(start.x, start.y, waypoints);
+        }
+        grid_found += !paths.empty();
+        mesh_found += found;
+    }
+    std::printf("%-24s %-10s found %4zu  expanded %7zu  %8.4f ms/query  length %.1f\n",
+                scenario.name, "grid", grid_found, grid_expanded / count, grid_ms / count, grid_length);
+    std::printf("%-24s %-10s found %4zu  expanded %7zu  %8.4f ms/query  length %.1f\n",
+                scenario.name, "navmesh", mesh_found, mesh_expanded / count, mesh_ms / count, mesh_length);
+
+    begin = std::chrono::steady_clock::now();
+    const float x = scenario.width * 0.5f;
+    const float y = scenario.height * 0.5f;
+    const int id = navmesh.add_obstacle(std::vector<NavMesh::Point>{ { x, y }, { x + 10.0f, y }, { x + 10.0f, y + 10.0f }, { x, y + 10.0f } });
+    end = std::chrono::steady_clock::now();
+    const size_t rebuilt = navmesh.get_rebuilt_count();
+    navmesh.remove_obstacle(id);
+    std::printf("%-24s %-10s add obstacle rebuilt %zu tiles  %.3f ms\n",
+                scenario.name,
+                "navmesh",
+                rebuilt,
+                std::chrono::duration<double, std::milli>(end - begin).count());
+}
+
+// 多终点寻路与逐个终点寻路比较，检查到每个终点的代价一致
+static void run_multi(const Scenario &scenario, int goals, uint32_t goal_limit)
+{
+    std::vector<char> maps = make_map(scenario);
+    GridMap grid(scenario.width, scenario.height);
+    grid.assign(maps.data(), 0);
+    grid.enable_neighbour_masks(true);
+    grid.enable_components(true);
+
+    std::vector<AStar::Vec2> ends;
+    for (const BatchFinder::Query &query : make_queries(grid, goals, 20200108))
+    {
+        ends.push_back(query.end);
+    }
+
+    AStar::Params param;
+    param.width = scenario.width;
+    param.height = scenario.height;
+    param.corner = scenario.corner;
+    param.start = AStar::Vec2(scenario.width / 2, scenario.height / 2);
+    param.goal_limit = goal_limit;
+
+    AStar algorithm;
+    std::vector<long> costs;
+    size_t expanded = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (const AStar::Vec2 &end : ends)
+    {
+        param.end = end;
+        costs.push_back(path_cost(param.start, algorithm.find(param, grid)));
+        expanded += algorithm.get_expanded_count();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s goals %d  expanded %9zu  %8.3f ms\n",
+                scenario.name,
+                "each",
+                goals,
+                expanded,
+                std::chrono::duration<double, std::milli>(end - begin).count());
+
+    std::vector<std::vector<AStar::Vec2>> paths;
+    begin = std::chrono::steady_clock::now();
+    algorithm.find_all(param, ends, grid, &paths);
+    end = std::chrono::steady_clock::now();
+    size_t different = 0;
+    for (size_t i = 0; i < ends.size(); ++i)
+    {
+        different += path_cost(param.start, paths[i]) != costs[i];
+    }
+    std::printf("%-24s %-10s goals %d  expanded %9zu  %8.3f ms  %s\n",
+                scenario.name,
+                "all",
+                goals,
+                algorithm.get_expanded_count(),
+                std::chrono::duration<double, std::milli>(end - begin).count(),
+                different == 0 ? "same cost" : "DIFFERENT");
+
+    size_t nearest = 0;
+    std::vector<AStar::Vec2> path;
+    begin = std::chrono::steady_clock::now();
+    algorithm.find_nearest(param, ends, grid, &nearest, &path);
+    end = std::chrono::steady_clock::now();
+    std::printf("%-24s %-10s goals %d  expanded %9zu  %8.3f ms  %s\n",
+                scenario.name,
+                "nearest",
+                goals,
+                algorithm.get_expanded_count(),
+                std::chrono::duration<double, std::milli>(end - begin).count(),
+                path_cost(param.start, path) == *std::min_element(costs.begin(), costs.end()) ? "nearest" : "NOT NEAREST");
+}
+
+// 在随机小地图上与参考 Dijkstra 比较，每张地图分别检查四方向和允许拐角
+static void run_reference(const Scenario &scenario, int maps, int count)
+{
+    std::mt19937 rng(20200105);
+    std::uniform_int_distribution<int> dist_density(0, 35);
+    std::uniform_int_distribution<int> dist_x(0, scenario.width - 1);
+    std::uniform_int_distribution<int> dist_y(0, scenario.height - 1);
+    auto random_cell = [&](const GridMap &grid)
+    {
+        while (true)
+        {
+            AStar::Vec2 pos(dist_x(rng), dist_y(rng));
+            if (grid.can_pass(pos))
+            {
+                return pos;
+            }
+        }
+    };
+
+    AStar algorithm;
+    size_t queries = 0;
+    size_t astar_bad = 0;
+    size_t jps_bad = 0;
+    size_t jump_bad = 0;
+    size_t hpa_bad = 0;
+    double hpa_ratio = 0.0;
+    size_t hpa_paths = 0;
+    size_t dstar_bad = 0;
+    size_t flow_bad = 0;
+    size_t flow_rounds = 0;
+    std::mt19937 flow_rng(20200107);
+    std::mt19937 component_rng(20200108);
+    size_t component_edits = 0;
+    size_t component_bad = 0;
+    size_t component_queries = 0;
+    size_t component_query_bad = 0;
+    size_t theta_bad = 0;
+    double theta_ratio = 0.0;
+    double theta_longest = 0.0;
+    size_t theta_paths = 0;
+    BasicAStar<RadixHeap> radix;
+    size_t radix_bad = 0;
+    WideAStar wide;
+    size_t wide_bad = 0;
+    size_t weight_bad = 0;
+    std::mt19937 weight_rng(20200106);
+    std::uniform_real_distribution<float> dist_weight(1.0f, 2.0f);
+    for (int m = 0; m < maps; ++m)
+    {
+        Scenario random = scenario;
+        random.density = dist_density(rng);
+        std::vector<char> cells = make_map(random, rng());
+        GridMap grid(scenario.width, scenario.height);
+        grid.assign(cells.data(), 0);
+        grid.enable_neighbour_masks(true);
+        GridMap online(scenario.width, scenario.height);
+        online.assign(cells.data(), 0);
+        grid.enable_jump_distances(true);
+
+        // 连通区域编号随修改增量更新，每次修改后与重新填充的结果比较，
+        // 并定期检查使用编号提前返回的寻路结果
+        GridMap labelled(scenario.width, scenario.height);
+        labelled.assign(cells.data(), 0);
+        labelled.enable_components(true);
+        for (int i = 0; i < count * 20; ++i)
+        {
+            const AStar::Vec2 pos(dist_x(component_rng), dist_y(component_rng));
+            labelled.set_pass(pos, !labelled.can_pass(pos));
+            component_bad += !same_components(labelled);
+            ++component_edits;
+            if (i % 10 == 0)
+            {
+                AStar::Params param;
+                param.width = scenario.width;
+                param.height = scenario.height;
+                param.corner = (i / 10) % 2 != 0;
+                param.start = AStar::Vec2(dist_x(component_rng), dist_y(component_rng));
+                param.end = AStar::Vec2(dist_x(component_rng), dist_y(component_rng));
+                if (labelled.can_pass(param.start))
+                {
+                    const long expected = reference_costs(labelled, param.start, param.corner)[param.end.y * scenario.width + param.end.x];
+                    component_query_bad += checked_cost(labelled, param.start, param.end, param.corner, algorithm.find(param, labelled)) != expected;
+                    ++component_queries;
+                }
+            }
+        }
+
+        for (int corner = 0; corner < 2; ++corner)
+        {
+            AStar::Params param;
+            param.width = scenario.width;
+            param.height = scenario.height;
+            param.corner = corner != 0;
+            for (int i = 0; i < count; ++i)
+            {
+                param.start = random_cell(grid);
+                param.end = random_cell(grid);
+                const long expected = reference_costs(grid, param.start, param.corner)[param.end.y * scenario.width + param.end.x];
+                ++queries;
+
+                param.mode = AStar::NORMAL;
+                astar_bad += checked_cost(grid, param.start, param.end, param.corner, algorithm.find(param, grid)) != expected;
+                param.mode = AStar::JPS;
+                jps_bad += checked_cost(grid, param.start, param.end, param.corner, algorithm.find(param, online)) != expected;
+                jump_bad += checked_cost(grid, param.start, param.end, param.corner, algorithm.find(param, grid)) != expected;
+                radix_bad += checked_cost(grid, param.start, param.end, param.corner, radix.find(param, grid)) != expected;
+                param.mode = AStar::NORMAL;
+                radix_bad += checked_cost(grid, param.start, param.end, param.corner, radix.find(param, online)) != expected;
+                wide_bad += checked_cost(grid, param.start, param.end, param.corner, wide.find(param, grid)) != expected;
+                param.mode = AStar::JPS;
+                wide_bad += checked_cost(grid, param.start, param.end, param.corner, wide.find(param, grid)) != expected;
+                param.mode = AStar::NORMAL;
+
+                // 加权A*的路径代价不超过最优的weight倍
+                param.weight = dist_weight(weight_rng);
+                const long weighted = checked_cost(grid, param.start, param.end, param.corner, algorithm.find(param, grid));
+                weight_bad += expected < 0 ? weighted != -1 : weighted < 0 || weighted > expected * param.weight;
+                param.weight = 1.0f;
+
+                // 任意角度路径只包含拐点，每一段都必须可直视，长度与最优格子路径比较
+                param.mode = AStar::THETA;
+                const std::vector<AStar::Vec2> turns = algorithm.find(param, grid);
+                bool clear = turns.empty() ? expected <= 0 : expected > 0 && turns.back() == param.end;
+                double length = 0.0;
+                AStar::Vec2 from = param.start;
+                for (const AStar::Vec2 &to : turns)
+                {
+                    clear = clear && segment_clear(grid, from, to);
+                    length += std::hypot(double(to.x) - from.x, double(to.y) - from.y);
+                    from = to;
+                }
+                theta_bad += !clear;
+                if (clear && expected > 0)
+                {
+                    const double ratio = length * AStar::kStepValue / expected;
+                    theta_ratio += ratio;
+                    theta_longest = std::max(theta_longest, ratio);
+                    ++theta_paths;
+                }
+            }
+
+            // 分层寻路在查询之间修改地图，路径必须合法，可到达时必须找到
+            GridMap edited(scenario.width, scenario.height);
+            edited.assign(cells.data(), 0);
+            HPAStar hpa;
+            hpa.build(edited, param.corner, 8);
+            for (int i = 0; i < count; ++i)
+            {
+                const AStar::Vec2 pos(dist_x(rng), dist_y(rng));
+                edited.set_pass(pos, !edited.can_pass(pos));
+                hpa.update(pos);
+
+                const AStar::Vec2 start = random_cell(edited);
+                const AStar::Vec2 end = random_cell(edited);
+                const long expected = reference_costs(edited, start, param.corner)[end.y * scenario.width + end.x];
+                const long cost = checked_cost(edited, start, end, param.corner, hpa.find(start, end));
+                hpa_bad += expected < 0 ? cost != -1 : cost < 0;
+                if (expected > 0 && cost > 0)
+                {
+                    hpa_ratio += double(cost) / expected;
+                    ++hpa_paths;
+                }
+            }
+
+            // 增量寻路每轮沿路径移动一步再修改若干格子，每次重新寻路都必须最优
+            GridMap replanned(scenario.width, scenario.height);
+            replanned.assign(cells.data(), 0);
+            AStar::Vec2 start = random_cell(replanned);
+            const AStar::Vec2 end = random_cell(replanned);
+            DStarLite planner;
+            planner.init(replanned, start, end, param.corner);
+            for (int i = 0; i < count; ++i)
+            {
+                const std::vector<AStar::Vec2> path = planner.find();
+                const long expected = reference_costs(replanned, start, param.corner)[end.y * scenario.width + end.x];
+                dstar_bad += checked_cost(replanned, start, end, param.corner, path) != expected;
+                if (!path.empty() && path.front() != end)
+                {
+                    start = path.front();
+                    planner.set_start(start);
+                }
+
+                std::vector<AStar::Vec2> flipped;
+                for (int j = 0; j < 3; ++j)
+                {
+                    const AStar::Vec2 pos(dist_x(rng), dist_y(rng));
+                    if (pos != start && pos != end)
+                    {
+                        replanned.set_pass(pos, !replanned.can_pass(pos));
+                        flipped.push_back(pos);
+                    }
+                }
+                planner.update(flipped);
+            }
+
+            // 流场每轮修改若干格子后增量更新，与重新生成的结果逐格比较，
+            // 并检查每个格子的方向都是合法的移动且与代价一致
+            GridMap flowed(scenario.width, scenario.height);
+            flowed.assign(cells.data(), 0);
+            auto flow_cell = [&]()
+            {
+                while (true)
+                {
+                    AStar::Vec2 pos(dist_x(flow_rng), dist_y(flow_rng));
+                    if (flowed.can_pass(pos))
+                    {
+                        return pos;
+                    }
+                }
+            };
+            const AStar::Vec2 goals[2] = { flow_cell(), flow_cell() };
+            FlowField field;
+            field.build(flowed, goals, param.corner);
+            for (int i = 0; i < count; ++i)
+            {
+                std::vector<AStar::Vec2> flipped;
+                for (int j = 0; j < 3; ++j)
+                {
+                    const AStar::Vec2 pos(dist_x(flow_rng), dist_y(flow_rng));
+                    if (pos != goals[0] && pos != goals[1])
+                    {
+                        flowed.set_pass(pos, !flowed.can_pass(pos));
+                        flipped.push_back(pos);
+                    }
+                }
+                field.update(flipped);
+
+                FlowField rebuilt;
+                rebuilt.build(flowed, goals, param.corner);
+                bool same = true;
+                for (int y = 0; y < scenario.height; ++y)
+                {
+                    for (int x = 0; x < scenario.width; ++x)
+                    {
+                        const AStar::Vec2 pos(x, y);
+                        const uint32_t distance = field.get_distance(pos);
+                        same = same && distance == rebuilt.get_distance(pos);
+                        const int direction = field.get_direction(pos);
+                        if (distance == FlowField::kUnreachable || direction < 0)
+                        {
+                            same = same && (distance == 0) == (direction < 0 && distance != FlowField::kUnreachable);
+                            continue;
+                        }
+                        const AStar::Vec2 next(x + AStar::kNeighbourX[direction], y + AStar::kNeighbourY[direction]);
+                        const long step = checked_cost(flowed, pos, next, param.corner, { next });
+                        same = same && step > 0 && field.get_distance(next) + step == distance;
+                    }
+                }
+                flow_bad += !same;
+                ++flow_rounds;
+            }
+        }
+    }
+
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref astar", maps, queries, astar_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref jps", maps, queries, jps_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref jps+", maps, queries, jump_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref radix", maps, queries, radix_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref wide", maps, queries, wide_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref weight", maps, queries, weight_bad == 0 ? "bounded" : "UNBOUNDED");
+    std::printf("%-24s %-10s maps %d  queries %zu  length %.3fx  max %.3fx  %s\n",
+                scenario.name,
+                "ref theta",
+                maps,
+                queries,
+                theta_paths > 0 ? theta_ratio / theta_paths : 1.0,
+                theta_longest,
+                theta_bad == 0 ? "visible" : "BLOCKED");
+    std::printf("%-24s %-10s maps %d  queries %zu  cost %.3fx  %s\n",
+                scenario.name,
+                "ref hpa",
+                maps,
+                queries,
+                hpa_paths > 0 ? hpa_ratio / hpa_paths : 1.0,
+                hpa_bad == 0 ? "valid" : "INVALID");
+    std::printf("%-24s %-10s maps %d  updates %zu  %s\n", scenario.name, "ref flow", maps, flow_rounds, flow_bad == 0 ? "same" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref d*", maps, queries, dstar_bad == 0 ? "same cost" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  edits %zu  %s\n", scenario.name, "ref labels", maps, component_edits, component_bad == 0 ? "same" : "DIFFERENT");
+    std::printf("%-24s %-10s maps %d  queries %zu  %s\n", scenario.name, "ref reach", maps, component_queries, component_query_bad == 0 ? "same cost" : "DIFFERENT");
+}
+
+int main()
+{
+    const Scenario scenarios[] =
+    {
+        { "open 1000x1000",         1000, 1000,  0, false,  0,    3 },
+        { "open 1000x1000 corner",  1000, 1000,  0, true,   0,    3 },
+        { "random20 1000x1000",     1000, 1000, 20, false,  0,    3 },
+        { "random20 1000x1000 c",   1000, 1000, 20, true,   0,    3 },
+        { "short 1000x1000",        1000, 1000,  0, false, 10, 1000 },
+    };
+
+    for (const Scenario &scenario : scenarios)
+    {
+        run(scenario);
+    }
+
+    run_batch(scenarios[2], 256);
+    run_service(scenarios[2], 256);
+    run_cache(scenarios[2], 32, 1000);
+    run_replan(scenarios[2], 20, 5);
+    run_flow(scenarios[3], 200, 20, 5);
+    run_unreachable(scenarios[3]);
+    run_sliced(scenarios[2], 4096);
+    run_landmarks({ "maze 1001x1001",         1001, 1001,  0, false,  0,    3 }, 8);
+    run_database({ "random20 64x64 c",         64,   64, 20, true,   0,    1 }, 1000);
+    run_subgoal({ "rooms 1000x1000 c",       1000, 1000,  0, true,   0,    3 }, 40, 200);
+    run_navmesh({ "rects 500x500 c",          500,  500,  0, true,   0,    1 }, 400, 50.0f, 200);
+    run_multi({ "random20 1000x1000 c",   1000, 1000, 20, true,   0,    1 }, 16, 4);
+    run_wide({ "random20 4000x4000",     4000, 4000, 20, false,  0,    3 });
+    run_reference({ "random 40x24",             40,   24,  0, false,  0,    1 }, 400, 8);
+    return 0;
+}
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <iostream>
 #include <array>
 #include <chrono>
 #include <cstdio>
 #include <memory>
+#include <optional>
 #include <string_view>
 
 #include <RVOSimulator.h>
@@ -13,7 +15,13 @@
 #include <imgui_sdl.h>
 
 #include "astar.h"
-#include "blockallocator.h"
+#include "gridmap.h"
+#include "flowfield.h"
+#include "pathcompress.h"
+#include "pathservice.h"
+#include "gridraster.h"
+#include "navmesh.h"
+#include "landmarks.h"
 
 using namespace std;
 
@@ -30,6 +38,7 @@ struct Simulation
     CIRCLE,
     DEADLOCK,
     ASTAR,
+    FLOWFIELD,
 
     _CONFIGURATION_COUNT,
   };
@@ -38,10 +47,11 @@ struct Simulation
       "Circle",
       "Deadlock",
       "ASTAR",
+      "FlowField",
     };
   struct options_t
   {
-    configuration_t configuration{ ASTAR }; // 两种模式，一个中 CIRCLE，一种是 DEADLOCK，一种是 ASTAR
+    configuration_t configuration{ ASTAR }; // 两种模式，一个中 CIRCLE，一种是 DEADLOCK，一种是 ASTAR，还有共用目标的 FLOWFIELD
     bool run_simulation{ false };  // 设置为 false，刚进去先不演示，按空格键开始演示
     bool show_goal{ false };
     bool show_velocity{ true };
@@ -52,7 +62,8 @@ struct Simulation
     float timeHorizonObst{ 10.0f };
     float radius{ 0.5f };  // 这个是 Agent 的半径，原本是 1.5f
     float maxSpeed{ 5.0f }; // 这个是 Agent 的最大速度，原来是 10.0f
-    int numAgents{ 10 };  // 一个场景中的 Agent 数量，只有 CIRCLE 用到
+    int numAgents{ 10 };  // 一个场景中的 Agent 数量，CIRCLE 和 FLOWFIELD 用到
+    bool use_navmesh{ false };  // ASTAR 场景的 Agent0 在导航网格上寻路，不使用格子地图
     float circleRadius{ 200 };
   };
   Simulation() = default;
@@ -71,6 +82,9 @@ struct Simulation
                                 options.maxSpeed);
 
     // 全局设置障碍物
+    // 每次初始化重新生成，上一次的障碍物和运行中画出的障碍物都不保留，
+    // 否则 build_map 的矩形每次重置都会再加一遍
+    obstacles.clear();
     // std::vector<RVO::Vector2> obstacle1, obstacle2, obstacle3, obstacle4;
     // obstacle1.push_back(RVO::Vector2(5, 5));
     // obstacle1.push_back(RVO::Vector2(5, -5));
@@ -92,6 +106,13 @@ struct Simulation
     // 默认是 250个 Agent
     // 目标点在圆的另外一边
     goals.clear();
+    use_flow_field = false;
+    search.reset();
+    follow_path = false;
+    replan_ticket.cancel();
+    replanned.reset();
+    use_navmesh = false;
+    navmesh_path.reset();
     // 场景一：
     // 对应的是 CIRCLE 模式
     if (options.configuration == CIRCLE) {
@@ -171,115 +192,48 @@ struct Simulation
       //   {0, 0, 0, 1, 0, 0, 0, 0, 0, 0},
       // };
       
-      char maps[61][61];
-      for(int i = 0; i <= 60; ++i) {
-        for(int j = 0; j <= 60; ++j) {
-          maps[i][j] = '0';
-        }
-      }
-
-      // maps 的障碍物
-      // for(int i = 0; i <= 25; ++i) {
-      //   for(int j = 15; j <= 60; ++j) {
-      //     maps[i][j] = '1';
-      //   }
-      // }
-      for(int i = 15; i <= 60; ++i) {
-        for(int j = 0; j <= 25; ++j) {
-          maps[i][j] = '1';
-        }
-      }
-
-      // for(int i = 30; i <= 60; ++i) {
-      //   for(int j = 0; j <= 50; ++j) {
-      //     maps[i][j] = '1';
-      //   }
-      // }
-
-      for(int i = 0; i <= 50; ++i) {
-        for(int j = 30; j <= 60; ++j) {
-          maps[i][j] = '1';
-        }
+      build_map(options);
+
+      // 导航网格直接由 simulator 中的障碍物生成，路径点是拉直的，拐点与障碍物保持 Agent 的半径
+      if (options.use_navmesh) {
+        navmesh.set_bounds(0, 0, 61, 61, 15);
+        navmesh.build_from_simulator(*simulator);
+        navmesh_end = RVO::Vector2(55, 55);
+        use_navmesh = true;
+        follow_path = true;
+        replan();
+        std::vector<RVO::Vector2> waypoints;
+        update_path(waypoints);
+        return waypoints;
       }
 
-      for(int i = 0; i <= 60; ++i) {
-        for(int j = 0; j <= 60; ++j) {
-          cout << maps[i][j];
-        }
-        cout << endl;
+      // ALT 路标保存在文件里，地图没有变化时下次启动直接载入，不用重新计算
+      if (!landmarks.load(kLandmarkFile, grid)) {
+        landmarks.build(grid, 4, true);
+        landmarks.save(kLandmarkFile);
       }
-
-
-      // 添加障碍物
-      // 两个障碍物
-      std::vector<RVO::Vector2> obstacle1, obstacle2, obstacle3, obstacle4;
-      obstacle1.push_back(RVO::Vector2(0, 15));
-      obstacle1.push_back(RVO::Vector2(25, 15));
-      obstacle1.push_back(RVO::Vector2(25, 60));
-      obstacle1.push_back(RVO::Vector2(0, 60));
-      obstacles.push_back(obstacle1);
-
-      obstacle2.push_back(RVO::Vector2(35, 0));
-      obstacle2.push_back(RVO::Vector2(60, 0));
-      obstacle2.push_back(RVO::Vector2(60, 50));
-      obstacle2.push_back(RVO::Vector2(35, 50));
-      obstacles.push_back(obstacle2);
+      path_finder.set_landmarks(&landmarks);
 
       // Astart
       // 搜索参数
       AStar::Params param;
-      param.width = 61;
-      param.height = 61;
+      param.width = grid.get_width();
+      param.height = grid.get_height();
       param.corner = false;
-      param.start = AStar::Vec2(5, 5);
-      param.end = AStar::Vec2(55, 55);
-      param.can_pass = [&](const AStar::Vec2 &pos) -> bool
-      {
-          return maps[pos.y][pos.x] == '0';
-      };
+      param.start = raster.to_cell(RVO::Vector2(5, 5));
+      param.end = raster.to_cell(RVO::Vector2(55, 55));
+      // 终点被围住时走到离它最近的可到达格子
+      param.nearest = true;
 
       // 执行搜索
-      BlockAllocator allocator;
-      AStar algorithm(&allocator);
-      // 得到每一步的 goal
-      std::vector<AStar::Vec2> path = algorithm.find(param);
-      if(path.size() == 0) {
-        cout << "???????????????????????????????????????????" << endl;
-      }
-      for(int i = 0; i < path.size(); ++i) {
-        cout << "ppppppppppppppppppppppppp" << endl;
-        cout << path[i].x << " " << path[i].y << endl;
-      }
-
-      // TO DO
-      // 优化一：
-      // 进行路径的合并
-      // param.start = AStar::Vec2(0, 0);
-      // param.end = AStar::Vec2(9, 9);
-      // std::vector<RVO::Vector2> CompressedPath;
-      // for(int i = 0; i < path.size(); ++i) {
-      //   CompressedPath.push_back(RVO::Vector2(path[i].x, path[i].y));
-      // }
-      
-      // for(int i = 0; i < path.size(); ++i) {
-      //   cout << path[i].x << " " << path[i].y << endl;
-      // }
-      
-      // return CompressedPath;
-
-      // 先 return 
-      std::vector<RVO::Vector2> tmp;
-      // 起点
-      tmp.push_back(RVO::Vector2(5,5));
-      // 剩余的路径点
-      // tmp.push_back(RVO::Vector2(30,5));
-      // tmp.push_back(RVO::Vector2(30,55));
-      // tmp.push_back(RVO::Vector2(55,55));
-      for(int i = 0; i < path.size(); ++i) {
-        tmp.push_back(RVO::Vector2(path[i].x, path[i].y));
-      }
-
-      return tmp;
+      // 分帧搜索，每帧最多扩展 kSearchBudget 个节点，避免大地图上卡住渲染线程
+      search.emplace(path_finder.find(param, grid, kSearchBudget));
+      search_end = param.end;
+      follow_path = true;
+      // 得到每一步的 goal，搜索没有结束时先沿目前离终点最近的路径走
+      std::vector<RVO::Vector2> waypoints;
+      update_path(waypoints);
+      return waypoints;
       // 定义障碍物的位置
       // std::vector<RVO::Vector2> obstacle1, obstacle2, obstacle3, obstacle4;
       // obstacle1.push_back(RVO::Vector2(5, 5));
@@ -290,14 +244,160 @@ struct Simulation
       
     }
 
-    // // 对场景中的所有 Agent 设置 偏好速度
+    // 场景四：
+    // 所有 Agent 前往同一个目标区域，共用一个流场
+    else if (options.configuration == FLOWFIELD) {
+      build_map(options);
+
+      // 目标区域在右下角
+      std::vector<AStar::Vec2> targets;
+      const AStar::Vec2 target_min = raster.to_cell(RVO::Vector2(54, 54));
+      const AStar::Vec2 target_max = raster.to_cell(RVO::Vector2(58, 58));
+      for (int y = target_min.y; y <= target_max.y; ++y) {
+        for (int x = target_min.x; x <= target_max.x; ++x) {
+          targets.emplace_back(x, y);
+        }
+      }
+      flow_field.build(grid, targets, true);
+      use_flow_field = true;
+
+      // Agent 排在左上角的空地里
+      for (int i = 0; i < options.numAgents; ++i) {
+        simulator->addAgent(RVO::Vector2(2 + (i % 8) * 3, 2 + (i / 8 % 4) * 3));
+        goals.emplace_back(56, 56);
+      }
+    }
+
+    // 对场景中的所有 Agent 设置 偏好速度
     // set_preferred_velocities();
+    return {};
+  }
+
+  // 演示用的地图，两个矩形障碍物加入 simulator 后再栅格化，地图与 ORCA 使用同一份障碍物
+  // 每个格子对应一个单位长度，格子 (x, y) 的中心在 (x, y)，障碍物按 Agent 的半径膨胀
+  void build_map(const options_t& options)
+  {
+    // 添加障碍物
+    // 两个障碍物
+    std::vector<RVO::Vector2> obstacle1, obstacle2;
+    obstacle1.push_back(RVO::Vector2(0, 15));
+    obstacle1.push_back(RVO::Vector2(25, 15));
+    obstacle1.push_back(RVO::Vector2(25, 60));
+    obstacle1.push_back(RVO::Vector2(0, 60));
+    obstacles.push_back(obstacle1);
+
+    obstacle2.push_back(RVO::Vector2(35, 0));
+    obstacle2.push_back(RVO::Vector2(60, 0));
+    obstacle2.push_back(RVO::Vector2(60, 50));
+    obstacle2.push_back(RVO::Vector2(35, 50));
+    obstacles.push_back(obstacle2);
+
+    simulator->addObstacle(obstacle1);
+    simulator->addObstacle(obstacle2);
+    simulator->processObstacles();
+
+    auto lock = path_service.lock_map();
+    raster.set_transform(0, 0, 1);
+    raster.set_inflation(options.radius);
+    raster.build_from_simulator(grid, 61, 61, *simulator);
+    grid.enable_neighbour_masks(true);
+    grid.enable_components(true);
+
+    for(int i = 0; i < grid.get_height(); ++i) {
+      for(int j = 0; j < grid.get_width(); ++j) {
+        cout << (grid.can_pass(j, i) ? '0' : '1');
+      }
+      cout << endl;
+    }
+  }
+
+  // 格子中心的世界坐标
+  RVO::Vector2 to_world(const AStar::Vec2& cell) const
+  {
+    const GridRaster::Point point = raster.to_world(cell);
+    return RVO::Vector2(point.x, point.y);
+  }
+
+  // 取得重新规划的结果或者继续分帧搜索，路径有变化时从 Agent0 的当前位置重新生成路径点，返回路径点是否更新
+  bool update_path(std::vector<RVO::Vector2>& waypoints)
+  {
+    if (navmesh_path) {
+      waypoints = std::move(*navmesh_path);
+      navmesh_path.reset();
+      return true;
+    }
+
+    std::vector<AStar::Vec2> path;
+    bool finished = true;
+    if (replanned) {
+      path = std::move(*replanned);
+      replanned.reset();
+    }
+    else if (search) {
+      finished = search->resume(kSearchBudget) != AStar::SEARCHING;
+      path = search->get_path();
+      if (finished) {
+        search.reset();
+      }
+    }
+    else {
+      return false;
+    }
+
+    if (finished) {
+      if(path.empty() || !(path.back() == search_end)) {
+        cout << "终点 (" << search_end.x << ", " << search_end.y << ") 不可到达";
+        if(!path.empty()) {
+          cout << "，改为前往最近的格子 (" << path.back().x << ", " << path.back().y << ")";
+        }
+        cout << endl;
+      }
+    }
+    else if (path.empty() || (!waypoints.empty() && RVO::abs(waypoints.back() - to_world(path.back())) < 1e-4f)) {
+      // 离终点最近的节点没有变化
+      return false;
+    }
+
+    // 优化一：
+    // 进行路径的合并
+    // 按视线去掉中间的格子，只保留拐点，视线检测考虑 Agent 的半径
+    // Agent 可能已经沿上一条路径走了一段，从路径上离它最近的格子开始
+    const RVO::Vector2 position = simulator->getAgentPosition(0);
+    size_t first = 0;
+    for (size_t i = 1; i < path.size(); ++i) {
+      if (RVO::absSq(to_world(path[i]) - position) < RVO::absSq(to_world(path[first]) - position)) {
+        first = i;
+      }
+    }
+    std::vector<RVO::Vector2> tmp;
+    // 起点
+    tmp.push_back(position);
+    // 剩余的路径点
+    for (size_t i = first; i < path.size(); ++i) {
+      tmp.push_back(to_world(path[i]));
+    }
+    tmp = compress_path(tmp, [&](const RVO::Vector2& a, const RVO::Vector2& b) {
+      return simulator->queryVisibility(a, b, simulator->getAgentRadius(0));
+    });
+    waypoints = std::move(tmp);
+    return true;
   }
 
   void set_preferred_velocities()
   {
     for (int i = 0; i < static_cast<int>(simulator->getNumAgents()); ++i) {
-      RVO::Vector2 goalVector = goals[i] - simulator->getAgentPosition(i);
+      const RVO::Vector2 position = simulator->getAgentPosition(i);
+      RVO::Vector2 goalVector = goals[i] - position;
+
+      // 共用流场时查所在格子的方向，朝下一个格子的中心走，到达目标区域后再直接走向目标
+      AStar::Vec2 cell;
+      if (use_flow_field && raster.to_cell(position.x(), position.y(), &cell)) {
+        const int direction = flow_field.get_direction(cell);
+        if (direction >= 0) {
+          const RVO::Vector2 next = to_world(AStar::Vec2(cell.x + AStar::kNeighbourX[direction], cell.y + AStar::kNeighbourY[direction]));
+          goalVector = RVO::normalize(next - position) * simulator->getAgentMaxSpeed(i);
+        }
+      }
 
       // i 是 Agent 的编号，goalVector 是偏好速度，也就是 目标的位置减去当前的位置所得的向量
       simulator->setAgentPrefVelocity(i, goalVector);
@@ -306,6 +406,8 @@ struct Simulation
 
   void step(float dt)
   {
+    // 每步交付一次后台寻路的结果
+    path_service.poll();
     simulator->setTimeStep(dt);
     // 只是做了一步，所以后面自动跳到了 (50, 50)
     // TO DO：如果 当前的 Agent 没有到达 最终的目标位置，持续地做 doStep
@@ -323,14 +425,95 @@ struct Simulation
       simulator->addObstacle(staging_obstacle);
       simulator->processObstacles();
       obstacles.emplace_back(staging_obstacle);
+      if (use_navmesh) {
+        navmesh.add_obstacle(staging_obstacle);
+      }
+      else if (use_flow_field || follow_path) {
+        block_cells(staging_obstacle);
+      }
+      if (follow_path) {
+        replan();
+      }
     }
     staging_obstacle.clear();
   }
 
+  // 地图变化后在后台为 Agent0 重新寻路，之前没有完成的请求已经过时，直接取消
+  void replan()
+  {
+    if (use_navmesh) {
+      replan_navmesh();
+      return;
+    }
+    search.reset();
+    replan_ticket.cancel();
+
+    const RVO::Vector2 position = simulator->getAgentPosition(0);
+    AStar::Params param;
+    param.width = grid.get_width();
+    param.height = grid.get_height();
+    param.corner = false;
+    param.start = raster.to_cell(position);
+    param.end = search_end;
+    param.nearest = true;
+    replan_ticket = path_service.submit(param, 1, [this](PathService::Path&& path) {
+      replanned = std::move(path);
+    });
+  }
+
+  // 在导航网格上为 Agent0 寻路，只重建了新障碍物所在的块，直接在主线程完成
+  void replan_navmesh()
+  {
+    const RVO::Vector2 position = simulator->getAgentPosition(0);
+    std::vector<NavMesh::Point> points;
+    if (!navmesh.find({ position.x(), position.y() }, { navmesh_end.x(), navmesh_end.y() },
+                      simulator->getAgentRadius(0), &points)) {
+      cout << "终点 (" << navmesh_end.x() << ", " << navmesh_end.y() << ") 不可到达" << endl;
+      return;
+    }
+    std::vector<RVO::Vector2> waypoints{ position };
+    for (const NavMesh::Point& point : points) {
+      waypoints.emplace_back(point.x, point.y);
+    }
+    // 三角形走廊在块的角上可能多出拐点，同样按视线去掉
+    navmesh_path = compress_path(waypoints, [&](const RVO::Vector2& a, const RVO::Vector2& b) {
+      return simulator->queryVisibility(a, b, simulator->getAgentRadius(0));
+    });
+  }
+
+  // 新的障碍物只重新栅格化它的包围盒，流场只更新受影响的部分
+  void block_cells(const std::vector<RVO::Vector2>& polygon)
+  {
+    auto lock = path_service.lock_map();
+    std::vector<AStar::Vec2> changed;
+    raster.add_obstacle(grid, polygon, &changed);
+    if (use_flow_field && !changed.empty()) {
+      flow_field.update(changed);
+    }
+  }
+
   std::unique_ptr<RVO::RVOSimulator> simulator;
   std::vector<RVO::Vector2> goals;
   std::vector<RVO::Vector2> staging_obstacle;
   std::vector<std::vector<RVO::Vector2>> obstacles;
+  GridMap grid;  // 演示用的地图
+  GridRaster raster;  // 障碍物栅格化和世界坐标与格子坐标的转换
+  FlowField flow_field;  // 所有 Agent 共用的流场
+  bool use_flow_field{ false };
+  static constexpr size_t kSearchBudget = 256;  // 每帧最多扩展的节点数
+  AStar path_finder;  // Agent0 的寻路，节点表在多次寻路之间保留
+  Landmarks landmarks;  // Agent0 寻路使用的 ALT 路标，地图修改后自动停用
+  static constexpr const char* kLandmarkFile = "astar_orca_landmarks.bin";
+  std::optional<AStar::Search<GridMap&>> search;  // 进行中的分帧搜索
+  AStar::Vec2 search_end;
+  bool follow_path{ false };  // Agent0 按路径点行走
+  PathService path_service{ grid, 1 };  // 后台寻路，地图修改前先取得独占锁
+  PathService::Ticket replan_ticket;  // 最近一次重新规划的请求
+  std::optional<std::vector<AStar::Vec2>> replanned;  // 重新规划的结果，由 poll 回调写入
+  NavMesh navmesh;  // Agent0 使用的导航网格
+  RVO::Vector2 navmesh_end;
+  bool use_navmesh{ false };
+  std::optional<std::vector<RVO::Vector2>> navmesh_path;  // 导航网格寻路的结果，包含 Agent0 的当前位置
 };
 
 /*************************************************************************************/
@@ -485,6 +668,7 @@ public:
     ImGui::Checkbox("Show Preferred velocity",
                     &simulation_options.show_velocity);
     ImGui::Checkbox("Run Simulation", &simulation_options.run_simulation);
+    ImGui::Checkbox("Use Navigation Mesh", &simulation_options.use_navmesh);
 
     auto item_current =
       Simulation::configuration_strings[simulation_options.configuration];
@@ -703,7 +887,15 @@ public:
     
     // 可能的 Bug 是 float 的相等性比较
     // if(simulation.simulator->getAgentPosition(0) == path[i] && ++i < path.size()) { // 或者等于 simulation.goals[0]
-    if(abs(simulation.simulator->getAgentPosition(0).x() - path[i].x()) < 10e-4 &&
+    // 只有 ASTAR 场景的 Agent0 按路径点行走
+    // 分帧搜索得到更好的路径或者重新规划完成时，从当前位置开始沿新路径走
+    if (simulation.update_path(path)) {
+      i = path.size() > 1 ? 1 : 0;
+      simulation.goals[0] = path[i];
+    }
+    const bool follow_path = simulation_options.configuration == Simulation::ASTAR && !path.empty();
+    if(follow_path &&
+       abs(simulation.simulator->getAgentPosition(0).x() - path[i].x()) < 10e-4 &&
        abs(simulation.simulator->getAgentPosition(0).y() - path[i].y()) < 10e-4 &&
        ++i < path.size()) {
       // cout << "xxxxxxxxx" << endl;
@@ -715,9 +907,11 @@ public:
       simulation.set_preferred_velocities();
       
       // 以下是 更新 Agent0 的逻辑
-      RVO::Vector2 goalVector = simulation.goals[0] - simulation.simulator->getAgentPosition(0);
-      // i 是 Agent 的编号，goalVector 是偏好速度，也就是 目标的位置减去当前的位置所得的向量
-      simulation.simulator->setAgentPrefVelocity(0, goalVector * 10);
+      if (follow_path) {
+        RVO::Vector2 goalVector = simulation.goals[0] - simulation.simulator->getAgentPosition(0);
+        // i 是 Agent 的编号，goalVector 是偏好速度，也就是 目标的位置减去当前的位置所得的向量
+        simulation.simulator->setAgentPrefVelocity(0, goalVector * 10);
+      }
 
       simulation.step(simulation_options.time_scale * dt.count());
     }
@@ -0,0 +1,122 @@
+#include "batchfinder.h"
+#include <algorithm>
+
+BatchFinder::BatchFinder(unsigned int thread_count)
+    : job_(nullptr)
+    , job_count_(0)
+    , next_(0)
+    , batch_(0)
+    , active_(0)
+    , stop_(false)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < thread_count; ++i)
+    {
+        algorithms_.push_back(std::make_unique<AStar>());
+    }
+    for (unsigned int i = 1; i < thread_count; ++i)
+    {
+        threads_.emplace_back(&BatchFinder::worker_main, this, i);
+    }
+}
+
+BatchFinder::~BatchFinder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cond_.notify_all();
+    for (std::thread &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+// 获取参与计算的线程数
+size_t BatchFinder::get_thread_count() const
+{
+    return algorithms_.size();
+}
+
+// 所有线程一起执行任务
+void BatchFinder::run(const Job &job, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // 请求较少时不必唤醒工作线程
+    if (threads_.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            job(*algorithms_[0], i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        job_count_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        active_ = threads_.size();
+        ++batch_;
+    }
+    start_cond_.notify_all();
+
+    work(*algorithms_[0]);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cond_.wait(lock, [this]() { return active_ == 0; });
+    job_ = nullptr;
+}
+
+// 领取并执行任务
+void BatchFinder::work(AStar &algorithm)
+{
+    while (true)
+    {
+        const size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= job_count_)
+        {
+            break;
+        }
+        (*job_)(algorithm, index);
+    }
+}
+
+// 工作线程主循环
+void BatchFinder::worker_main(size_t index)
+{
+    AStar &algorithm = *algorithms_[index];
+    uint64_t batch = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cond_.wait(lock, [&]() { return stop_ || batch_ != batch; });
+            if (stop_)
+            {
+                return;
+            }
+            batch = batch_;
+        }
+
+        work(algorithm);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0)
+            {
+                done_cond_.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef __BATCHFINDER_H__
+#define __BATCHFINDER_H__
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include "astar.h"
+
+/**
+ * 批量寻路
+ * 常驻的工作线程各自持有一个 AStar，调用线程也参与计算，线程之间不共享搜索状态。
+ * 每个请求的结果只与请求本身有关，按请求的顺序输出，与线程数无关
+ */
+class BatchFinder
+{
+public:
+    typedef AStar::Vec2 Vec2;
+    typedef std::vector<Vec2> Path;
+
+    /**
+     * 寻路请求
+     */
+    struct Query
+    {
+        Vec2        start;      // 起点坐标
+        Vec2        end;        // 终点坐标
+    };
+
+public:
+    /**
+     * thread_count 为参与计算的线程数(含调用线程)，为0时使用硬件线程数
+     */
+    explicit BatchFinder(unsigned int thread_count = 0);
+
+    ~BatchFinder();
+
+    BatchFinder(const BatchFinder&) = delete;
+
+    BatchFinder& operator= (const BatchFinder&) = delete;
+
+public:
+    /**
+     * 获取参与计算的线程数
+     */
+    size_t get_thread_count() const;
+
+    /**
+     * 批量执行寻路操作，param 提供地图尺寸、拐角和搜索方式，忽略其中的起点和终点。
+     * can_pass 与 AStar::find 相同，会被多个线程同时读取
+     */
+    template<typename GridPolicy>
+    std::vector<Path> find_batch(const AStar::Params &param, std::span<const Query> queries, const GridPolicy &can_pass);
+
+private:
+    /**
+     * 任务，参数为当前线程的 AStar 和请求下标
+     */
+    typedef std::function<void(AStar&, size_t)> Job;
+
+    /**
+     * 所有线程一起执行任务，返回时全部完成
+     */
+    void run(const Job &job, size_t count);
+
+    /**
+     * 领取并执行任务直到没有剩余
+     */
+    void work(AStar &algorithm);
+
+    /**
+     * 工作线程主循环
+     */
+    void worker_main(size_t index);
+
+private:
+    std::vector<std::unique_ptr<AStar>> algorithms_;    // 每个线程一个，第0个属于调用线程
+    std::vector<std::thread>            threads_;
+    std::mutex                          mutex_;
+    std::condition_variable             start_cond_;
+    std::condition_variable             done_cond_;
+    const Job*                          job_;
+    size_t                              job_count_;
+    std::atomic<size_t>                 next_;          // 下一个待领取的请求
+    uint64_t                            batch_;         // 批次编号，工作线程据此发现新任务
+    size_t                              active_;        // 尚未完成当前批次的工作线程数
+    bool                                stop_;
+};
+
+// 批量执行寻路操作
+template<typename GridPolicy>
+std::vector<BatchFinder::Path> BatchFinder::find_batch(const AStar::Params &param, std::span<const Query> queries, const GridPolicy &can_pass)
+{
+    std::vector<Path> paths(queries.size());
+    const Job job = [&](AStar &algorithm, size_t index)
+    {
+        AStar::Params query = param;
+        query.start = queries[index].start;
+        query.end = queries[index].end;
+        paths[index] = algorithm.find(query, can_pass);
+    };
+    run(job, queries.size());
+    return paths;
+}
+
+#endif
@@ -0,0 +1,364 @@
+#include "dstarlite.h"
+#include "gridmap.h"
+#include <algorithm>
+
+// 不溢出的加法
+static inline uint32_t saturate_add(uint32_t a, uint32_t b)
+{
+    return a > DStarLite::kInfinity - b ? DStarLite::kInfinity : a + b;
+}
+
+DStarLite::DStarLite()
+    : map_(nullptr)
+    , corner_(false)
+    , width_(0)
+    , height_(0)
+    , km_(0)
+    , expanded_(0)
+{
+}
+
+// 开始新的寻路
+void DStarLite::init(const GridMap &map, const Vec2 &start, const Vec2 &end, bool corner)
+{
+    map_ = &map;
+    corner_ = corner;
+    width_ = map.get_width();
+    height_ = map.get_height();
+    start_ = start;
+    last_start_ = start;
+    end_ = end;
+    km_ = 0;
+
+    const size_t size = size_t(width_) * height_;
+    g_.assign(size, kInfinity);
+    rhs_.assign(size, kInfinity);
+    position_.assign(size, kNotInQueue);
+    queue_.clear();
+
+    // 反向搜索，从终点出发
+    if (end.x < width_ && end.y < height_)
+    {
+        update_vertex(to_index(end));
+    }
+}
+
+// 起点移动到新的位置
+void DStarLite::set_start(const Vec2 &start)
+{
+    km_ = saturate_add(km_, calcul_h_value(last_start_, start));
+    last_start_ = start;
+    start_ = start;
+}
+
+// 格子发生变化
+void DStarLite::update(const Vec2 &pos)
+{
+    update(std::span<const Vec2>(&pos, 1));
+}
+
+// 一批格子发生变化
+// 格子周围3x3范围内的边都可能改变，包括绕过它的斜向边，逐个重新计算rhs值
+void DStarLite::update(std::span<const Vec2> cells)
+{
+    assert(map_ != nullptr);
+    for (const Vec2 &pos : cells)
+    {
+        for (int y = pos.y - 1; y <= pos.y + 1; ++y)
+        {
+            for (int x = pos.x - 1; x <= pos.x + 1; ++x)
+            {
+                if (x >= 0 && x < width_ && y >= 0 && y < height_)
+                {
+                    update_vertex(to_index(Vec2(x, y)));
+                }
+            }
+        }
+    }
+}
+
+// 执行寻路操作
+std::vector<DStarLite::Vec2> DStarLite::find()
+{
+    std::vector<Vec2> paths;
+    assert(map_ != nullptr);
+    if (map_ == nullptr || start_.x >= width_ || start_.y >= height_ || end_.x >= width_ || end_.y >= height_)
+    {
+        return paths;
+    }
+
+    // 起点不可通过时不必修复，否则会扩展整个连通区域
+    expanded_ = 0;
+    if (!map_->can_pass(start_))
+    {
+        return paths;
+    }
+    compute_shortest_path();
+
+    uint32_t current = to_index(start_);
+    if (g_[current] == kInfinity)
+    {
+        return paths;
+    }
+
+    // 沿g值下降最快的方向走到终点
+    const uint32_t end_index = to_index(end_);
+    while (current != end_index)
+    {
+        const Vec2 pos = to_pos(current);
+        unsigned int mask = get_neighbour_mask(current);
+        uint32_t best = kInfinity;
+        uint32_t next = current;
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            const uint32_t neighbour = to_index(Vec2(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i]));
+            const uint32_t cost = saturate_add(g_[neighbour], (i & 1) ? AStar::kObliqueValue : AStar::kStepValue);
+            if (cost < best)
+            {
+                best = cost;
+                next = neighbour;
+            }
+        }
+        if (next == current || paths.size() >= g_.size())
+        {
+            paths.clear();
+            break;
+        }
+        current = next;
+        paths.push_back(to_pos(current));
+    }
+    return paths;
+}
+
+// 获取上次寻路扩展的节点数
+size_t DStarLite::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 坐标转换为格子索引
+uint32_t DStarLite::to_index(const Vec2 &pos) const
+{
+    return uint32_t(pos.y) * width_ + pos.x;
+}
+
+// 格子索引转换为坐标
+DStarLite::Vec2 DStarLite::to_pos(uint32_t index) const
+{
+    return Vec2(index % width_, index / width_);
+}
+
+// 格子的可通过邻居掩码
+unsigned int DStarLite::get_neighbour_mask(uint32_t index) const
+{
+    const Vec2 pos = to_pos(index);
+    if (!map_->can_pass(pos))
+    {
+        return 0;
+    }
+    unsigned int mask = map_->get_neighbour_mask(pos);
+    return corner_ ? mask : mask & AStar::kStraightMask;
+}
+
+// 计算H值，与移动代价一致
+uint32_t DStarLite::calcul_h_value(const Vec2 &from, const Vec2 &to) const
+{
+    const uint32_t dx = abs(to.x - from.x);
+    const uint32_t dy = abs(to.y - from.y);
+    if (!corner_)
+    {
+        return (dx + dy) * AStar::kStepValue;
+    }
+    const uint32_t oblique = std::min(dx, dy);
+    return oblique * AStar::kObliqueValue + (std::max(dx, dy) - oblique) * AStar::kStepValue;
+}
+
+// 计算格子的排序键值
+uint64_t DStarLite::calcul_key(uint32_t index) const
+{
+    const uint32_t value = std::min(g_[index], rhs_[index]);
+    const uint32_t k1 = saturate_add(saturate_add(value, calcul_h_value(start_, to_pos(index))), km_);
+    return (uint64_t(k1) << 32) | value;
+}
+
+// 根据邻居的g值计算rhs值
+uint32_t DStarLite::calcul_rhs_value(uint32_t index) const
+{
+    const Vec2 pos = to_pos(index);
+    unsigned int mask = get_neighbour_mask(index);
+    uint32_t rhs = kInfinity;
+    while (mask != 0)
+    {
+        const int i = std::countr_zero(mask);
+        mask &= mask - 1;
+        const uint32_t neighbour = to_index(Vec2(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i]));
+        rhs = std::min(rhs, saturate_add(g_[neighbour], (i & 1) ? AStar::kObliqueValue : AStar::kStepValue));
+    }
+    return rhs;
+}
+
+// 更新格子的rhs值和在队列中的位置
+void DStarLite::update_vertex(uint32_t index)
+{
+    if (to_pos(index) == end_)
+    {
+        rhs_[index] = map_->can_pass(end_) ? 0 : kInfinity;
+    }
+    else
+    {
+        rhs_[index] = calcul_rhs_value(index);
+    }
+
+    if (g_[index] != rhs_[index])
+    {
+        queue_update(index, calcul_key(index));
+    }
+    else if (position_[index] != kNotInQueue)
+    {
+        queue_remove(index);
+    }
+}
+
+// 修复搜索直到起点的代价确定
+void DStarLite::compute_shortest_path()
+{
+    const uint32_t start = to_index(start_);
+    while (!queue_.empty() && (queue_.front().key < calcul_key(start) || rhs_[start] != g_[start]))
+    {
+        const uint32_t current = queue_.front().index;
+        const uint64_t old_key = queue_.front().key;
+        const uint64_t new_key = calcul_key(current);
+        ++expanded_;
+
+        if (old_key < new_key)
+        {
+            // 起点移动后键值变大，重新排序
+            queue_update(current, new_key);
+            continue;
+        }
+
+        if (g_[current] > rhs_[current])
+        {
+            g_[current] = rhs_[current];
+            queue_remove(current);
+        }
+        else
+        {
+            g_[current] = kInfinity;
+            update_vertex(current);
+        }
+
+        // 邻居关系是对称的，前驱即为可通过的邻居
+        const Vec2 pos = to_pos(current);
+        unsigned int mask = get_neighbour_mask(current);
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            update_vertex(to_index(Vec2(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i])));
+        }
+    }
+}
+
+// 放入或更新队列中的格子
+void DStarLite::queue_update(uint32_t index, uint64_t key)
+{
+    size_t hole = position_[index];
+    if (hole == kNotInQueue)
+    {
+        queue_.push_back({ key, index });
+        percolate_up(queue_.size() - 1);
+        return;
+    }
+
+    const uint64_t old_key = queue_[hole].key;
+    queue_[hole].key = key;
+    if (key < old_key)
+    {
+        percolate_up(hole);
+    }
+    else
+    {
+        percolate_down(hole);
+    }
+}
+
+// 从队列中移除格子
+void DStarLite::queue_remove(uint32_t index)
+{
+    const size_t hole = position_[index];
+    position_[index] = kNotInQueue;
+    const Entry last = queue_.back();
+    queue_.pop_back();
+    if (hole == queue_.size())
+    {
+        return;
+    }
+
+    const uint64_t old_key = queue_[hole].key;
+    queue_[hole] = last;
+    position_[last.index] = hole;
+    if (last.key < old_key)
+    {
+        percolate_up(hole);
+    }
+    else
+    {
+        percolate_down(hole);
+    }
+}
+
+// 堆上滤
+void DStarLite::percolate_up(size_t hole)
+{
+    const Entry entry = queue_[hole];
+    while (hole > 0)
+    {
+        size_t parent = (hole - 1) / 2;
+        if (entry.key < queue_[parent].key)
+        {
+            queue_[hole] = queue_[parent];
+            position_[queue_[hole].index] = hole;
+            hole = parent;
+        }
+        else
+        {
+            break;
+        }
+    }
+    queue_[hole] = entry;
+    position_[entry.index] = hole;
+}
+
+// 堆下滤
+void DStarLite::percolate_down(size_t hole)
+{
+    const Entry entry = queue_[hole];
+    const size_t size = queue_.size();
+    while (true)
+    {
+        size_t child = hole * 2 + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && queue_[child + 1].key < queue_[child].key)
+        {
+            ++child;
+        }
+        if (queue_[child].key < entry.key)
+        {
+            queue_[hole] = queue_[child];
+            position_[queue_[hole].index] = hole;
+            hole = child;
+        }
+        else
+        {
+            break;
+        }
+    }
+    queue_[hole] = entry;
+    position_[entry.index] = hole;
+}
@@ -0,0 +1,146 @@
+#ifndef __DSTARLITE_H__
+#define __DSTARLITE_H__
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+
+class GridMap;
+
+/**
+ * 增量寻路(D* Lite)
+ * 从终点向起点反向搜索，并在两次寻路之间保留每个格子的g值和rhs值。
+ * 地图上的格子发生变化后只修复受影响的部分，起点移动时不需要重新搜索。
+ * 代价与 AStar 相同，直行为10，斜向为14，斜向移动要求两侧的直行格子可通过
+ */
+class DStarLite
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    static constexpr uint32_t kInfinity = UINT32_MAX;
+
+public:
+    DStarLite();
+
+public:
+    /**
+     * 开始新的寻路，地图需要在使用期间保持有效
+     */
+    void init(const GridMap &map, const Vec2 &start, const Vec2 &end, bool corner);
+
+    /**
+     * 起点移动到新的位置
+     */
+    void set_start(const Vec2 &start);
+
+    /**
+     * 地图上的格子发生变化，调用前地图已经修改
+     */
+    void update(const Vec2 &pos);
+
+    /**
+     * 地图上的一批格子发生变化
+     */
+    void update(std::span<const Vec2> cells);
+
+    /**
+     * 执行寻路操作，返回不含起点的格子路径，与 AStar::find 一致
+     */
+    std::vector<Vec2> find();
+
+    /**
+     * 获取上次寻路扩展的节点数
+     */
+    size_t get_expanded_count() const;
+
+private:
+    /**
+     * 优先队列元素，键值高32位为k1，低32位为k2
+     */
+    struct Entry
+    {
+        uint64_t    key;
+        uint32_t    index;
+    };
+
+    static constexpr uint32_t kNotInQueue = UINT32_MAX;
+
+    /**
+     * 坐标转换为格子索引
+     */
+    uint32_t to_index(const Vec2 &pos) const;
+
+    /**
+     * 格子索引转换为坐标
+     */
+    Vec2 to_pos(uint32_t index) const;
+
+    /**
+     * 格子的可通过邻居掩码，顺序与 AStar::kNeighbourX/kNeighbourY 一致
+     */
+    unsigned int get_neighbour_mask(uint32_t index) const;
+
+    /**
+     * 计算H值
+     */
+    uint32_t calcul_h_value(const Vec2 &from, const Vec2 &to) const;
+
+    /**
+     * 计算格子的排序键值
+     */
+    uint64_t calcul_key(uint32_t index) const;
+
+    /**
+     * 根据邻居的g值计算rhs值
+     */
+    uint32_t calcul_rhs_value(uint32_t index) const;
+
+    /**
+     * 更新格子的rhs值和在队列中的位置
+     */
+    void update_vertex(uint32_t index);
+
+    /**
+     * 修复搜索直到起点的代价确定
+     */
+    void compute_shortest_path();
+
+    /**
+     * 放入或更新队列中的格子
+     */
+    void queue_update(uint32_t index, uint64_t key);
+
+    /**
+     * 从队列中移除格子
+     */
+    void queue_remove(uint32_t index);
+
+    /**
+     * 堆上滤
+     */
+    void percolate_up(size_t hole);
+
+    /**
+     * 堆下滤
+     */
+    void percolate_down(size_t hole);
+
+private:
+    const GridMap*          map_;
+    bool                    corner_;
+    uint16_t                width_;
+    uint16_t                height_;
+    Vec2                    start_;
+    Vec2                    end_;
+    Vec2                    last_start_;    // 上次修正km_时的起点
+    uint32_t                km_;            // 起点移动累计的H值偏移
+    std::vector<uint32_t>   g_;
+    std::vector<uint32_t>   rhs_;
+    std::vector<Entry>      queue_;         // 二叉堆
+    std::vector<uint32_t>   position_;      // 格子在堆中的位置
+    size_t                  expanded_;
+};
+
+#endif
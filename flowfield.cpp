@@ -0,0 +1,273 @@
+#include "flowfield.h"
+#include "gridmap.h"
+#include <bit>
+#include <cassert>
+
+FlowField::FlowField()
+    : map_(nullptr)
+    , corner_(false)
+    , width_(0)
+    , height_(0)
+    , expanded_(0)
+{
+}
+
+// 以一组格子为目标生成流场
+void FlowField::build(const GridMap &map, std::span<const Vec2> goals, bool corner)
+{
+    map_ = &map;
+    corner_ = corner;
+    width_ = map.get_width();
+    height_ = map.get_height();
+    expanded_ = 0;
+
+    const size_t size = size_t(width_) * height_;
+    distances_.assign(size, kUnreachable);
+    directions_.assign(size, kNoDirection);
+    queued_.assign(size, 0);
+    open_list_.reset(size);
+
+    // 目标标记保留到下次生成，不可通过的目标在变为可通过时重新成为起点
+    for (const Vec2 &goal : goals)
+    {
+        if (goal.x < width_ && goal.y < height_)
+        {
+            const uint32_t index = to_index(goal);
+            directions_[index] = kGoal;
+            seed(index);
+        }
+    }
+    flood();
+}
+
+// 以单个格子为目标生成流场
+void FlowField::build(const GridMap &map, const Vec2 &goal, bool corner)
+{
+    build(map, std::span<const Vec2>(&goal, 1), corner);
+}
+
+// 格子发生变化
+void FlowField::update(const Vec2 &pos)
+{
+    update(std::span<const Vec2>(&pos, 1));
+}
+
+// 一批格子发生变化
+// 格子周围3x3范围内的边都可能改变。先作废方向不再可通行的格子及其下游，
+// 再从它们和变化的格子开始重新扩散，没有受影响的格子保持原来的代价
+void FlowField::update(std::span<const Vec2> cells)
+{
+    assert(map_ != nullptr);
+    expanded_ = 0;
+    invalid_.clear();
+
+    auto for_each_nearby = [&](auto &&func)
+    {
+        for (const Vec2 &pos : cells)
+        {
+            for (int y = pos.y - 1; y <= pos.y + 1; ++y)
+            {
+                for (int x = pos.x - 1; x <= pos.x + 1; ++x)
+                {
+                    if (x >= 0 && x < width_ && y >= 0 && y < height_)
+                    {
+                        func(to_index(Vec2(x, y)));
+                    }
+                }
+            }
+        }
+    };
+
+    for_each_nearby([&](uint32_t index)
+    {
+        if (distances_[index] != kUnreachable && !is_valid_direction(index))
+        {
+            invalidate(index);
+        }
+    });
+
+    for (uint32_t index : invalid_)
+    {
+        seed(index);
+    }
+    for_each_nearby([&](uint32_t index) { seed(index); });
+    flood();
+}
+
+// 获取格子的下一步方向
+int FlowField::get_direction(const Vec2 &pos) const
+{
+    if (pos.x >= width_ || pos.y >= height_)
+    {
+        return -1;
+    }
+    const uint8_t direction = directions_[to_index(pos)];
+    return direction < kGoal ? direction : -1;
+}
+
+// 获取格子到目标的代价
+uint32_t FlowField::get_distance(const Vec2 &pos) const
+{
+    if (pos.x >= width_ || pos.y >= height_)
+    {
+        return kUnreachable;
+    }
+    return distances_[to_index(pos)];
+}
+
+// 获取上次生成或更新扩展的格子数
+size_t FlowField::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 坐标转换为格子索引
+uint32_t FlowField::to_index(const Vec2 &pos) const
+{
+    return uint32_t(pos.y) * width_ + pos.x;
+}
+
+// 格子索引转换为坐标
+FlowField::Vec2 FlowField::to_pos(uint32_t index) const
+{
+    return Vec2(index % width_, index / width_);
+}
+
+// 格子的可通过邻居掩码
+unsigned int FlowField::get_neighbour_mask(uint32_t index) const
+{
+    const Vec2 pos = to_pos(index);
+    if (!map_->can_pass(pos))
+    {
+        return 0;
+    }
+    unsigned int mask = map_->get_neighbour_mask(pos);
+    return corner_ ? mask : mask & AStar::kStraightMask;
+}
+
+// 格子的方向是否仍然可以通行，目标格子要求本身可通过
+bool FlowField::is_valid_direction(uint32_t index) const
+{
+    const uint8_t direction = directions_[index];
+    if (direction == kGoal)
+    {
+        return map_->can_pass(to_pos(index));
+    }
+    return direction < kGoal && ((get_neighbour_mask(index) >> direction) & 1) != 0;
+}
+
+// 作废格子以及所有经过它到达目标的格子
+// 下游格子的方向指向已作废的格子，按方向反查8个邻居即可，不需要保存子节点
+void FlowField::invalidate(uint32_t index)
+{
+    size_t current = invalid_.size();
+    auto reset = [&](uint32_t cell)
+    {
+        distances_[cell] = kUnreachable;
+        if (directions_[cell] != kGoal)
+        {
+            directions_[cell] = kNoDirection;
+        }
+        invalid_.push_back(cell);
+    };
+
+    reset(index);
+    while (current < invalid_.size())
+    {
+        const Vec2 pos = to_pos(invalid_[current++]);
+        for (int i = 0; i < 8; ++i)
+        {
+            const int x = pos.x + AStar::kNeighbourX[i];
+            const int y = pos.y + AStar::kNeighbourY[i];
+            if (x < 0 || x >= width_ || y < 0 || y >= height_)
+            {
+                continue;
+            }
+            const uint32_t neighbour = to_index(Vec2(x, y));
+            if (distances_[neighbour] != kUnreachable && directions_[neighbour] == ((i + 4) & 7))
+            {
+                reset(neighbour);
+            }
+        }
+    }
+}
+
+// 从相邻格子重新计算代价
+void FlowField::seed(uint32_t index)
+{
+    if (directions_[index] == kGoal)
+    {
+        if (distances_[index] != 0 && map_->can_pass(to_pos(index)))
+        {
+            relax(index, 0, kGoal);
+        }
+        return;
+    }
+
+    const Vec2 pos = to_pos(index);
+    unsigned int mask = get_neighbour_mask(index);
+    uint32_t best = distances_[index];
+    uint8_t best_direction = kNoDirection;
+    while (mask != 0)
+    {
+        const int i = std::countr_zero(mask);
+        mask &= mask - 1;
+        const uint32_t neighbour = to_index(Vec2(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i]));
+        if (distances_[neighbour] == kUnreachable)
+        {
+            continue;
+        }
+        const uint32_t distance = distances_[neighbour] + ((i & 1) ? AStar::kObliqueValue : AStar::kStepValue);
+        if (distance < best)
+        {
+            best = distance;
+            best_direction = uint8_t(i);
+        }
+    }
+    if (best_direction != kNoDirection)
+    {
+        relax(index, best, best_direction);
+    }
+}
+
+// 格子的代价变小
+void FlowField::relax(uint32_t index, uint32_t distance, uint8_t direction)
+{
+    distances_[index] = distance;
+    directions_[index] = direction;
+    if (queued_[index])
+    {
+        open_list_.decrease(index, distance, distance);
+    }
+    else
+    {
+        queued_[index] = 1;
+        open_list_.push(index, distance, distance);
+    }
+}
+
+// 扩散直到开启列表为空
+// 邻居关系是对称的，从格子向外扩散时邻居的方向为反方向
+void FlowField::flood()
+{
+    while (!open_list_.empty())
+    {
+        const uint32_t current = open_list_.pop();
+        queued_[current] = 0;
+        ++expanded_;
+
+        const Vec2 pos = to_pos(current);
+        unsigned int mask = get_neighbour_mask(current);
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            const uint32_t neighbour = to_index(Vec2(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i]));
+            const uint32_t distance = distances_[current] + ((i & 1) ? AStar::kObliqueValue : AStar::kStepValue);
+            if (distance < distances_[neighbour])
+            {
+                relax(neighbour, distance, uint8_t((i + 4) & 7));
+            }
+        }
+    }
+}
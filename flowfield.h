@@ -0,0 +1,123 @@
+#ifndef __FLOWFIELD_H__
+#define __FLOWFIELD_H__
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+#include "openlist.h"
+
+class GridMap;
+
+/**
+ * 流场
+ * 从目标区域反向扩散(Dijkstra)，为每个格子记录到目标的代价和下一步的方向，
+ * 前往同一目标的多个 Agent 共用一个流场，每个 Agent 查询方向为 O(1)。
+ * 地图上的格子变化后只重新计算受影响的格子。
+ * 代价与 AStar 相同，直行为10，斜向为14，斜向移动要求两侧的直行格子可通过
+ */
+class FlowField
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+public:
+    FlowField();
+
+public:
+    /**
+     * 以一组格子为目标生成流场，地图需要在使用期间保持有效
+     */
+    void build(const GridMap &map, std::span<const Vec2> goals, bool corner);
+
+    /**
+     * 以单个格子为目标生成流场
+     */
+    void build(const GridMap &map, const Vec2 &goal, bool corner);
+
+    /**
+     * 地图上的格子发生变化，调用前地图已经修改
+     */
+    void update(const Vec2 &pos);
+
+    /**
+     * 地图上的一批格子发生变化
+     */
+    void update(std::span<const Vec2> cells);
+
+    /**
+     * 获取格子的下一步方向，为 AStar::kNeighbourX/kNeighbourY 的下标，
+     * 位于目标、不可到达或越界时返回-1
+     */
+    int get_direction(const Vec2 &pos) const;
+
+    /**
+     * 获取格子到目标的代价，不可到达或越界时返回kUnreachable
+     */
+    uint32_t get_distance(const Vec2 &pos) const;
+
+    /**
+     * 获取上次生成或更新扩展的格子数
+     */
+    size_t get_expanded_count() const;
+
+private:
+    static constexpr uint8_t kGoal = 8;         // 目标格子
+    static constexpr uint8_t kNoDirection = 9;  // 没有方向
+
+    /**
+     * 坐标转换为格子索引
+     */
+    uint32_t to_index(const Vec2 &pos) const;
+
+    /**
+     * 格子索引转换为坐标
+     */
+    Vec2 to_pos(uint32_t index) const;
+
+    /**
+     * 格子的可通过邻居掩码，格子本身不可通过时为0
+     */
+    unsigned int get_neighbour_mask(uint32_t index) const;
+
+    /**
+     * 格子的方向是否仍然可以通行
+     */
+    bool is_valid_direction(uint32_t index) const;
+
+    /**
+     * 作废格子以及所有经过它到达目标的格子
+     */
+    void invalidate(uint32_t index);
+
+    /**
+     * 从相邻格子重新计算代价，变小时放入开启列表
+     */
+    void seed(uint32_t index);
+
+    /**
+     * 格子的代价变小，放入或调整开启列表
+     */
+    void relax(uint32_t index, uint32_t distance, uint8_t direction);
+
+    /**
+     * 扩散直到开启列表为空
+     */
+    void flood();
+
+private:
+    const GridMap*          map_;
+    bool                    corner_;
+    uint16_t                width_;
+    uint16_t                height_;
+    std::vector<uint32_t>   distances_;     // 到目标的代价
+    std::vector<uint8_t>    directions_;    // 下一步方向
+    std::vector<uint8_t>    queued_;        // 是否在开启列表中
+    std::vector<uint32_t>   invalid_;       // 本次更新作废的格子
+    BinaryHeap              open_list_;
+    size_t                  expanded_;
+};
+
+#endif
@@ -0,0 +1,535 @@
+#include "gridmap.h"
+#include <algorithm>
+#include <cassert>
+
+static const int kMaxJump = INT16_MAX;
+
+GridMap::GridMap()
+    : width_(0)
+    , height_(0)
+    , stride_(0)
+    , jumps_valid_(false)
+    , revision_(0)
+{
+}
+
+GridMap::GridMap(uint16_t width, uint16_t height)
+    : GridMap()
+{
+    resize(width, height);
+}
+
+// 重设地图尺寸
+void GridMap::resize(uint16_t width, uint16_t height)
+{
+    width_ = width;
+    height_ = height;
+    stride_ = (width_ + 63) / 64;
+    blocked_.assign(stride_ * height_, 0);
+    jumps_valid_ = false;
+    ++revision_;
+    if (!masks_.empty())
+    {
+        masks_.clear();
+        enable_neighbour_masks(true);
+    }
+    if (!components_.empty())
+    {
+        build_components();
+    }
+}
+
+// 从字符数组载入
+void GridMap::assign(const char *cells, char passable)
+{
+    std::fill(blocked_.begin(), blocked_.end(), 0);
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            if (cells[y * width_ + x] != passable)
+            {
+                blocked_[y * stride_ + (x >> 6)] |= uint64_t(1) << (x & 63);
+            }
+        }
+    }
+    jumps_valid_ = false;
+    ++revision_;
+    if (!masks_.empty())
+    {
+        masks_.clear();
+        enable_neighbour_masks(true);
+    }
+    if (!components_.empty())
+    {
+        build_components();
+    }
+}
+
+// 获取地图宽度
+uint16_t GridMap::get_width() const
+{
+    return width_;
+}
+
+// 获取地图高度
+uint16_t GridMap::get_height() const
+{
+    return height_;
+}
+
+// 设置是否可通过
+void GridMap::set_pass(const Vec2 &pos, bool pass)
+{
+    if (pos.x >= width_ || pos.y >= height_)
+    {
+        return;
+    }
+
+    uint64_t &word = blocked_[pos.y * stride_ + (pos.x >> 6)];
+    const uint64_t bit = uint64_t(1) << (pos.x & 63);
+    const uint64_t value = pass ? (word & ~bit) : (word | bit);
+    if (value == word)
+    {
+        return;
+    }
+    word = value;
+    jumps_valid_ = false;
+    ++revision_;
+
+    if (!masks_.empty())
+    {
+        update_neighbour_masks(pos.x, pos.y);
+    }
+    if (!components_.empty())
+    {
+        update_components(pos.x, pos.y, pass);
+    }
+}
+
+// 获取地图版本
+uint64_t GridMap::get_revision() const
+{
+    return revision_;
+}
+
+// 计算地图内容的哈希值(FNV-1a)，按行把可通过性打包成64位，行末多余的位为0
+uint64_t GridMap::get_hash() const
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    mix(width_);
+    mix(height_);
+    const uint64_t tail = (width_ & 63) == 0 ? ~uint64_t(0) : (uint64_t(1) << (width_ & 63)) - 1;
+    for (int y = 0; y < height_; ++y)
+    {
+        for (size_t i = 0; i < stride_; ++i)
+        {
+            const uint64_t bits = ~blocked_[y * stride_ + i];
+            mix(i + 1 == stride_ ? bits & tail : bits);
+        }
+    }
+    return hash;
+}
+
+// 开启或关闭邻域掩码预计算
+void GridMap::enable_neighbour_masks(bool enable)
+{
+    if (!enable)
+    {
+        std::vector<uint8_t>().swap(masks_);
+        return;
+    }
+
+    masks_.resize(size_t(width_) * height_);
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            masks_[size_t(y) * width_ + x] = calcul_neighbour_mask(x, y);
+        }
+    }
+}
+
+// 是否预计算了邻域掩码
+bool GridMap::has_neighbour_masks() const
+{
+    return !masks_.empty();
+}
+
+// 计算8邻域可通过掩码
+uint8_t GridMap::calcul_neighbour_mask(int x, int y) const
+{
+    uint8_t mask = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        const int dx = AStar::kNeighbourX[i];
+        const int dy = AStar::kNeighbourY[i];
+        if (!can_pass(x + dx, y + dy))
+        {
+            continue;
+        }
+        // 斜向移动要求两侧的直行格子都可通过
+        if (dx != 0 && dy != 0 && !(can_pass(x + dx, y) && can_pass(x, y + dy)))
+        {
+            continue;
+        }
+        mask |= uint8_t(1) << i;
+    }
+    return mask;
+}
+
+// 更新格子周围的邻域掩码
+void GridMap::update_neighbour_masks(int x, int y)
+{
+    for (int row = y - 1; row <= y + 1; ++row)
+    {
+        for (int col = x - 1; col <= x + 1; ++col)
+        {
+            if (col >= 0 && col < width_ && row >= 0 && row < height_)
+            {
+                masks_[size_t(row) * width_ + col] = calcul_neighbour_mask(col, row);
+            }
+        }
+    }
+}
+
+// 开启或关闭跳跃距离预计算
+void GridMap::enable_jump_distances(bool enable)
+{
+    if (enable)
+    {
+        build_jump_distances();
+    }
+    else
+    {
+        std::vector<int16_t>().swap(jumps_);
+        jumps_valid_ = false;
+    }
+}
+
+// 跳跃距离是否可用
+bool GridMap::has_jump_distances() const
+{
+    return jumps_valid_;
+}
+
+// 直行到达格子时是否存在强迫邻居
+bool GridMap::has_forced_neighbour(int x, int y, int dx, int dy) const
+{
+    if (dx != 0)
+    {
+        return (can_pass(x, y - 1) && !can_pass(x - dx, y - 1))
+            || (can_pass(x, y + 1) && !can_pass(x - dx, y + 1));
+    }
+    return (can_pass(x - 1, y) && !can_pass(x - 1, y - dy))
+        || (can_pass(x + 1, y) && !can_pass(x + 1, y - dy));
+}
+
+// 计算全部跳跃距离
+// 每张表沿跳跃方向的反方向递推：下一格不可通过为0，下一格是跳点为1，
+// 否则在下一格的结果上再走一步。超出int16范围时把下一格当作跳点
+void GridMap::build_jump_distances()
+{
+    jumps_.assign(size_t(width_) * height_ * kJumpTables, 0);
+    auto jump = [this](int x, int y, int table) -> int16_t&
+    {
+        return jumps_[(size_t(y) * width_ + x) * kJumpTables + table];
+    };
+    auto extend = [](int distance) -> int16_t
+    {
+        if (distance >= kMaxJump || distance <= -kMaxJump)
+        {
+            return 1;
+        }
+        return distance > 0 ? distance + 1 : distance - 1;
+    };
+
+    // 按从远到近的顺序遍历方向(dx, dy)
+    auto sweep = [this](int dx, int dy, auto &&visit)
+    {
+        for (int row = 0; row < height_; ++row)
+        {
+            const int y = dy > 0 ? height_ - 1 - row : row;
+            for (int col = 0; col < width_; ++col)
+            {
+                const int x = dx > 0 ? width_ - 1 - col : col;
+                visit(x, y);
+            }
+        }
+    };
+
+    // 直行
+    for (int i = 0; i < 8; i += 2)
+    {
+        const int dx = AStar::kNeighbourX[i];
+        const int dy = AStar::kNeighbourY[i];
+        sweep(dx, dy, [&](int x, int y)
+        {
+            const int nx = x + dx;
+            const int ny = y + dy;
+            int16_t &distance = jump(x, y, i);
+            if (!can_pass(nx, ny))
+            {
+                distance = 0;
+            }
+            else if (has_forced_neighbour(nx, ny, dx, dy))
+            {
+                distance = 1;
+            }
+            else
+            {
+                distance = extend(jump(nx, ny, i));
+            }
+        });
+    }
+
+    // 斜向，直行方向上存在跳点的格子为跳点
+    for (int i = 1; i < 8; i += 2)
+    {
+        const int dx = AStar::kNeighbourX[i];
+        const int dy = AStar::kNeighbourY[i];
+        const int table_x = dx > 0 ? 0 : 4;
+        const int table_y = dy > 0 ? 2 : 6;
+        sweep(dx, dy, [&](int x, int y)
+        {
+            const int nx = x + dx;
+            const int ny = y + dy;
+            int16_t &distance = jump(x, y, i);
+            if (!can_pass(nx, ny) || !can_pass(nx, y) || !can_pass(x, ny))
+            {
+                distance = 0;
+            }
+            else if (jump(nx, ny, table_x) > 0 || jump(nx, ny, table_y) > 0)
+            {
+                distance = 1;
+            }
+            else
+            {
+                distance = extend(jump(nx, ny, i));
+            }
+        });
+    }
+
+    // 四方向规则的纵向，横向上存在跳点的格子为跳点
+    for (int table = 8; table < kJumpTables; ++table)
+    {
+        const int dy = table == 8 ? 1 : -1;
+        sweep(0, dy, [&](int x, int y)
+        {
+            const int ny = y + dy;
+            int16_t &distance = jump(x, y, table);
+            if (!can_pass(x, ny))
+            {
+                distance = 0;
+            }
+            else if (has_forced_neighbour(x, ny, 0, dy) || jump(x, ny, 0) > 0 || jump(x, ny, 4) > 0)
+            {
+                distance = 1;
+            }
+            else
+            {
+                distance = extend(jump(x, ny, table));
+            }
+        });
+    }
+
+    jumps_valid_ = true;
+}
+
+// 开启或关闭连通区域编号
+void GridMap::enable_components(bool enable)
+{
+    if (enable)
+    {
+        build_components();
+    }
+    else
+    {
+        std::vector<uint32_t>().swap(components_);
+        std::vector<uint32_t>().swap(component_sizes_);
+        std::vector<uint32_t>().swap(free_components_);
+    }
+}
+
+// 是否维护了连通区域编号
+bool GridMap::has_components() const
+{
+    return !components_.empty();
+}
+
+// 计算全部连通区域
+void GridMap::build_components()
+{
+    components_.assign(size_t(width_) * height_, 0);
+    component_sizes_.assign(1, 0);
+    free_components_.clear();
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            if (can_pass(x, y) && components_[size_t(y) * width_ + x] == 0)
+            {
+                const uint32_t component = new_component();
+                component_sizes_[component] = flood_component(x, y, 0, component);
+            }
+        }
+    }
+}
+
+// 格子可通过性变化后更新连通区域
+// 变为可通过时合并四周的区域，较小的区域改用最大区域的编号。
+// 变为不可通过时四周的格子可能被分开，四周一圈格子中相连的只算一组，
+// 多于一组时从前面几组重新编号，剩下的一组保留原编号
+void GridMap::update_components(int x, int y, bool pass)
+{
+    auto component_at = [this](int cx, int cy) -> uint32_t
+    {
+        return can_pass(cx, cy) ? components_[size_t(cy) * width_ + cx] : 0;
+    };
+    uint32_t &cell = components_[size_t(y) * width_ + x];
+
+    if (pass)
+    {
+        uint32_t largest = 0;
+        for (int i = 0; i < 8; i += 2)
+        {
+            const uint32_t component = component_at(x + AStar::kNeighbourX[i], y + AStar::kNeighbourY[i]);
+            if (component != 0 && (largest == 0 || component_sizes_[component] > component_sizes_[largest]))
+            {
+                largest = component;
+            }
+        }
+        if (largest == 0)
+        {
+            largest = new_component();
+        }
+        cell = largest;
+        ++component_sizes_[largest];
+
+        for (int i = 0; i < 8; i += 2)
+        {
+            const int nx = x + AStar::kNeighbourX[i];
+            const int ny = y + AStar::kNeighbourY[i];
+            const uint32_t component = component_at(nx, ny);
+            if (component != 0 && component != largest)
+            {
+                component_sizes_[largest] += flood_component(nx, ny, component, largest);
+                component_sizes_[component] = 0;
+                free_components_.push_back(component);
+            }
+        }
+        return;
+    }
+
+    const uint32_t old = cell;
+    assert(old != 0);
+    cell = 0;
+    --component_sizes_[old];
+
+    // 四周一圈中连续可通过的格子互相连通，按组记录直行方向的邻居
+    int groups[4][2];
+    int count = 0;
+    int start = 0;
+    while (start < 8 && can_pass(x + AStar::kNeighbourX[start], y + AStar::kNeighbourY[start]))
+    {
+        ++start;
+    }
+    if (start == 8)
+    {
+        return;
+    }
+    bool new_group = true;
+    for (int k = 1; k <= 8; ++k)
+    {
+        const int i = (start + k) & 7;
+        const int nx = x + AStar::kNeighbourX[i];
+        const int ny = y + AStar::kNeighbourY[i];
+        if (!can_pass(nx, ny))
+        {
+            new_group = true;
+            continue;
+        }
+        if ((i & 1) == 0 && new_group)
+        {
+            groups[count][0] = nx;
+            groups[count][1] = ny;
+            ++count;
+            new_group = false;
+        }
+    }
+
+    if (count == 0)
+    {
+        assert(component_sizes_[old] == 0);
+        free_components_.push_back(old);
+        return;
+    }
+
+    for (int i = 0; i + 1 < count; ++i)
+    {
+        const int nx = groups[i][0];
+        const int ny = groups[i][1];
+        if (components_[size_t(ny) * width_ + nx] == old)
+        {
+            const uint32_t component = new_component();
+            component_sizes_[component] = flood_component(nx, ny, old, component);
+            component_sizes_[old] -= component_sizes_[component];
+        }
+    }
+    if (component_sizes_[old] == 0)
+    {
+        free_components_.push_back(old);
+    }
+}
+
+// 分配连通区域编号
+uint32_t GridMap::new_component()
+{
+    if (!free_components_.empty())
+    {
+        const uint32_t component = free_components_.back();
+        free_components_.pop_back();
+        return component;
+    }
+    component_sizes_.push_back(0);
+    return uint32_t(component_sizes_.size() - 1);
+}
+
+// 把相连的格子改为新的编号
+uint32_t GridMap::flood_component(int x, int y, uint32_t from, uint32_t to)
+{
+    static const int kStraightX[4] = { 1, 0, -1, 0 };
+    static const int kStraightY[4] = { 0, 1, 0, -1 };
+    uint32_t count = 1;
+    std::vector<uint32_t> stack;
+    components_[size_t(y) * width_ + x] = to;
+    stack.push_back(uint32_t(y) * width_ + x);
+    while (!stack.empty())
+    {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        const int cx = index % width_;
+        const int cy = index / width_;
+        for (int i = 0; i < 4; ++i)
+        {
+            const int nx = cx + kStraightX[i];
+            const int ny = cy + kStraightY[i];
+            if (can_pass(nx, ny) && components_[size_t(ny) * width_ + nx] == from)
+            {
+                components_[size_t(ny) * width_ + nx] = to;
+                stack.push_back(uint32_t(ny) * width_ + nx);
+                ++count;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,225 @@
+#ifndef __GRIDMAP_H__
+#define __GRIDMAP_H__
+
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+
+/**
+ * 栅格地图
+ * 每个格子占1位，可选地为每个格子预计算8邻域掩码，
+ * 掩码的位顺序与 AStar::kNeighbourX/kNeighbourY 一致，斜向的位已包含拐角规则
+ * 也可预计算每个方向上的跳跃距离，供 JPS+ 使用，
+ * 以及连通区域编号，供寻路在搜索前排除不可到达的终点
+ */
+class GridMap
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    static const int kJumpTables = 10;  // 8个方向加上四方向规则的2个纵向
+
+public:
+    GridMap();
+
+    GridMap(uint16_t width, uint16_t height);
+
+public:
+    /**
+     * 重设地图尺寸，所有格子可通过
+     */
+    void resize(uint16_t width, uint16_t height);
+
+    /**
+     * 从按行存放的字符数组载入，等于passable的格子可通过
+     */
+    void assign(const char *cells, char passable);
+
+    /**
+     * 获取地图宽度
+     */
+    uint16_t get_width() const;
+
+    /**
+     * 获取地图高度
+     */
+    uint16_t get_height() const;
+
+    /**
+     * 是否可通过，越界返回false
+     */
+    bool can_pass(int x, int y) const;
+
+    /**
+     * 是否可通过，越界返回false
+     */
+    bool can_pass(const Vec2 &pos) const;
+
+    /**
+     * 设置是否可通过
+     */
+    void set_pass(const Vec2 &pos, bool pass);
+
+    /**
+     * 获取地图版本，地图内容每次变化都会增加
+     */
+    uint64_t get_revision() const;
+
+    /**
+     * 计算地图内容的哈希值，只与尺寸和可通过性有关，用于校验保存的预计算数据
+     */
+    uint64_t get_hash() const;
+
+    /**
+     * 开启或关闭邻域掩码预计算
+     */
+    void enable_neighbour_masks(bool enable);
+
+    /**
+     * 是否预计算了邻域掩码
+     */
+    bool has_neighbour_masks() const;
+
+    /**
+     * 获取8邻域可通过掩码
+     */
+    uint8_t get_neighbour_mask(const Vec2 &pos) const;
+
+    /**
+     * 开启或关闭跳跃距离预计算
+     * 修改地图后预计算结果失效，需要重新开启
+     */
+    void enable_jump_distances(bool enable);
+
+    /**
+     * 跳跃距离是否可用
+     */
+    bool has_jump_distances() const;
+
+    /**
+     * 获取跳跃距离
+     * 正数为到下一个跳点的步数，否则绝对值为撞墙前可走的步数
+     * direction 为 AStar::kNeighbourX/kNeighbourY 的下标，corner 为 false 时使用四方向规则
+     */
+    int get_jump_distance(const Vec2 &pos, int direction, bool corner) const;
+
+    /**
+     * 开启或关闭连通区域编号，开启后随 set_pass 增量更新
+     */
+    void enable_components(bool enable);
+
+    /**
+     * 是否维护了连通区域编号
+     */
+    bool has_components() const;
+
+    /**
+     * 获取格子所在的连通区域编号，不可通过或越界为0
+     * 斜向移动要求两侧的直行格子可通过，因此按四方向划分的区域同样适用于允许拐角的寻路
+     */
+    uint32_t get_component(const Vec2 &pos) const;
+
+private:
+    /**
+     * 计算8邻域可通过掩码
+     */
+    uint8_t calcul_neighbour_mask(int x, int y) const;
+
+    /**
+     * 更新格子周围的邻域掩码
+     */
+    void update_neighbour_masks(int x, int y);
+
+    /**
+     * 直行到达格子时是否存在强迫邻居
+     */
+    bool has_forced_neighbour(int x, int y, int dx, int dy) const;
+
+    /**
+     * 计算全部跳跃距离
+     */
+    void build_jump_distances();
+
+    /**
+     * 计算全部连通区域
+     */
+    void build_components();
+
+    /**
+     * 格子可通过性变化后更新连通区域
+     */
+    void update_components(int x, int y, bool pass);
+
+    /**
+     * 分配连通区域编号
+     */
+    uint32_t new_component();
+
+    /**
+     * 从格子开始把编号为from的相连格子改为to，返回修改的格子数
+     */
+    uint32_t flood_component(int x, int y, uint32_t from, uint32_t to);
+
+private:
+    uint16_t                width_;
+    uint16_t                height_;
+    size_t                  stride_;        // 每行占用的64位字数
+    std::vector<uint64_t>   blocked_;       // 不可通过的格子
+    std::vector<uint8_t>    masks_;         // 邻域掩码
+    std::vector<int16_t>    jumps_;         // 跳跃距离，每个格子kJumpTables个
+    bool                    jumps_valid_;   // 跳跃距离是否与地图一致
+    std::vector<uint32_t>   components_;    // 连通区域编号
+    std::vector<uint32_t>   component_sizes_;   // 每个编号的格子数，0号不使用
+    std::vector<uint32_t>   free_components_;   // 可复用的编号
+    uint64_t                revision_;      // 地图版本
+};
+
+// 是否可通过
+inline bool GridMap::can_pass(int x, int y) const
+{
+    if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    {
+        return false;
+    }
+    return ((blocked_[y * stride_ + (x >> 6)] >> (x & 63)) & 1) == 0;
+}
+
+// 是否可通过
+inline bool GridMap::can_pass(const Vec2 &pos) const
+{
+    return can_pass(pos.x, pos.y);
+}
+
+// 获取8邻域可通过掩码
+inline uint8_t GridMap::get_neighbour_mask(const Vec2 &pos) const
+{
+    if (!masks_.empty())
+    {
+        return masks_[size_t(pos.y) * width_ + pos.x];
+    }
+    return calcul_neighbour_mask(pos.x, pos.y);
+}
+
+// 获取跳跃距离
+inline int GridMap::get_jump_distance(const Vec2 &pos, int direction, bool corner) const
+{
+    // 四方向规则的纵向跳跃存放在最后两张表
+    int table = direction;
+    if (!corner && (direction & 3) == 2)
+    {
+        table = direction == 2 ? 8 : 9;
+    }
+    return jumps_[(size_t(pos.y) * width_ + pos.x) * kJumpTables + table];
+}
+
+// 获取连通区域编号
+inline uint32_t GridMap::get_component(const Vec2 &pos) const
+{
+    if (components_.empty() || pos.x >= width_ || pos.y >= height_)
+    {
+        return 0;
+    }
+    return components_[size_t(pos.y) * width_ + pos.x];
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "gridraster.h"
+#include "gridmap.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+GridRaster::GridRaster()
+    : origin_x_(0.0f)
+    , origin_y_(0.0f)
+    , cell_size_(1.0f)
+    , inflation_(0.0f)
+    , width_(0)
+    , height_(0)
+{
+}
+
+// 设置坐标映射
+void GridRaster::set_transform(float origin_x, float origin_y, float cell_size)
+{
+    assert(cell_size > 0.0f);
+    origin_x_ = origin_x;
+    origin_y_ = origin_y;
+    cell_size_ = cell_size;
+}
+
+// 设置膨胀半径
+void GridRaster::set_inflation(float radius)
+{
+    inflation_ = std::max(radius, 0.0f);
+}
+
+// 获取格子边长
+float GridRaster::get_cell_size() const
+{
+    return cell_size_;
+}
+
+// 获取膨胀半径
+float GridRaster::get_inflation() const
+{
+    return inflation_;
+}
+
+// 世界坐标转换为所在的格子
+bool GridRaster::to_cell(float x, float y, Vec2 *out_cell) const
+{
+    const int cell_x = int(std::floor((x - origin_x_) / cell_size_ + 0.5f));
+    const int cell_y = int(std::floor((y - origin_y_) / cell_size_ + 0.5f));
+    if (width_ == 0 || height_ == 0)
+    {
+        out_cell->reset(0, 0);
+        return false;
+    }
+    out_cell->reset(std::clamp(cell_x, 0, width_ - 1), std::clamp(cell_y, 0, height_ - 1));
+    return cell_x == out_cell->x && cell_y == out_cell->y;
+}
+
+// 格子中心的世界坐标
+GridRaster::Point GridRaster::to_world(const Vec2 &cell) const
+{
+    return { origin_x_ + cell.x * cell_size_, origin_y_ + cell.y * cell_size_ };
+}
+
+// 清空保存的障碍物
+void GridRaster::clear()
+{
+    polygons_.clear();
+}
+
+// 添加障碍物
+void GridRaster::add_polygon(std::vector<Point> points)
+{
+    assert(!points.empty());
+    Polygon polygon;
+    polygon.min = points.front();
+    polygon.max = points.front();
+    for (const Point &point : points)
+    {
+        polygon.min.x = std::min(polygon.min.x, point.x);
+        polygon.min.y = std::min(polygon.min.y, point.y);
+        polygon.max.x = std::max(polygon.max.x, point.x);
+        polygon.max.y = std::max(polygon.max.y, point.y);
+    }
+    polygon.points = std::move(points);
+    polygons_.push_back(std::move(polygon));
+}
+
+// 按保存的障碍物重建地图
+// 先写入字符数组再一次载入，邻域掩码和连通区域只重建一次
+void GridRaster::build(GridMap &grid, uint16_t width, uint16_t height)
+{
+    width_ = width;
+    height_ = height;
+    std::vector<char> cells(size_t(width) * height, 0);
+    for (const Polygon &polygon : polygons_)
+    {
+        CellBox box;
+        if (!get_cell_box(polygon, &box))
+        {
+            continue;
+        }
+        for (int y = box.min_y; y <= box.max_y; ++y)
+        {
+            for (int x = box.min_x; x <= box.max_x; ++x)
+            {
+                char &cell = cells[size_t(y) * width + x];
+                if (cell == 0 && is_blocked(polygon, to_world(Vec2(x, y))))
+                {
+                    cell = 1;
+                }
+            }
+        }
+    }
+
+    if (grid.get_width() != width || grid.get_height() != height)
+    {
+        grid.resize(width, height);
+    }
+    grid.assign(cells.data(), 0);
+}
+
+// 新增障碍物，只重新栅格化它的包围盒
+// 包围盒内的格子按所有与包围盒相交的障碍物重新判断
+void GridRaster::add_obstacle(GridMap &grid, std::vector<Point> points, std::vector<Vec2> *out_changed)
+{
+    add_polygon(std::move(points));
+    CellBox box;
+    if (!get_cell_box(polygons_.back(), &box))
+    {
+        return;
+    }
+
+    std::vector<const Polygon*> nearby;
+    for (const Polygon &polygon : polygons_)
+    {
+        CellBox other;
+        if (get_cell_box(polygon, &other)
+            && other.min_x <= box.max_x && other.max_x >= box.min_x
+            && other.min_y <= box.max_y && other.max_y >= box.min_y)
+        {
+            nearby.push_back(&polygon);
+        }
+    }
+
+    for (int y = box.min_y; y <= box.max_y; ++y)
+    {
+        for (int x = box.min_x; x <= box.max_x; ++x)
+        {
+            const Vec2 cell(x, y);
+            const Point center = to_world(cell);
+            const bool blocked = std::any_of(nearby.begin(), nearby.end(), [&](const Polygon *polygon)
+            {
+                return is_blocked(*polygon, center);
+            });
+            if (grid.can_pass(cell) == blocked)
+            {
+                grid.set_pass(cell, !blocked);
+                if (out_changed != nullptr)
+                {
+                    out_changed->push_back(cell);
+                }
+            }
+        }
+    }
+}
+
+// 障碍物膨胀后的包围盒覆盖的格子
+bool GridRaster::get_cell_box(const Polygon &polygon, CellBox *out_box) const
+{
+    out_box->min_x = std::max(0, int(std::ceil((polygon.min.x - inflation_ - origin_x_) / cell_size_)));
+    out_box->min_y = std::max(0, int(std::ceil((polygon.min.y - inflation_ - origin_y_) / cell_size_)));
+    out_box->max_x = std::min(width_ - 1, int(std::floor((polygon.max.x + inflation_ - origin_x_) / cell_size_)));
+    out_box->max_y = std::min(height_ - 1, int(std::floor((polygon.max.y + inflation_ - origin_y_) / cell_size_)));
+    return out_box->min_x <= out_box->max_x && out_box->min_y <= out_box->max_y;
+}
+
+// 点是否在障碍物内或者距离不超过膨胀半径
+// 射线法判断是否在多边形内，与顶点顺序无关，边上的点按距离为0处理
+bool GridRaster::is_blocked(const Polygon &polygon, const Point &point) const
+{
+    if (point.x < polygon.min.x - inflation_ || point.x > polygon.max.x + inflation_
+        || point.y < polygon.min.y - inflation_ || point.y > polygon.max.y + inflation_)
+    {
+        return false;
+    }
+
+    const std::vector<Point> &points = polygon.points;
+    bool inside = false;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+    {
+        const Point &a = points[j];
+        const Point &b = points[i];
+
+        // 到边的距离
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float length = dx * dx + dy * dy;
+        float t = 0.0f;
+        if (length > 0.0f)
+        {
+            t = std::clamp(((point.x - a.x) * dx + (point.y - a.y) * dy) / length, 0.0f, 1.0f);
+        }
+        const float ex = a.x + t * dx - point.x;
+        const float ey = a.y + t * dy - point.y;
+        if (ex * ex + ey * ey <= inflation_ * inflation_)
+        {
+            return true;
+        }
+
+        if (points.size() > 2 && (a.y > point.y) != (b.y > point.y)
+            && point.x < dx * (point.y - a.y) / dy + a.x)
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
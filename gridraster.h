@@ -0,0 +1,193 @@
+#ifndef __GRIDRASTER_H__
+#define __GRIDRASTER_H__
+
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+
+class GridMap;
+
+/**
+ * 障碍物栅格化
+ * 把多边形障碍物写入 GridMap，格子中心到障碍物的距离不超过膨胀半径时不可通过，
+ * 通常取 Agent 的半径。多边形的顶点顺序不限，两个顶点的障碍物按线段处理。
+ * 保存所有障碍物，新增障碍物时只重新栅格化它膨胀后的包围盒。
+ * 同时负责世界坐标与格子坐标之间的转换，格子 (x, y) 的中心在 origin + (x, y) * cell_size
+ */
+class GridRaster
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    /**
+     * 世界坐标
+     */
+    struct Point
+    {
+        float x;
+        float y;
+    };
+
+public:
+    GridRaster();
+
+public:
+    /**
+     * 设置坐标映射，origin 为格子 (0, 0) 中心的世界坐标
+     */
+    void set_transform(float origin_x, float origin_y, float cell_size);
+
+    /**
+     * 设置膨胀半径，之后栅格化的格子生效
+     */
+    void set_inflation(float radius);
+
+    /**
+     * 获取格子边长
+     */
+    float get_cell_size() const;
+
+    /**
+     * 获取膨胀半径
+     */
+    float get_inflation() const;
+
+    /**
+     * 世界坐标转换为所在的格子，超出地图时取最近的格子并返回false
+     */
+    bool to_cell(float x, float y, Vec2 *out_cell) const;
+
+    /**
+     * 世界坐标转换为所在的格子，超出地图时取最近的格子
+     */
+    template<typename Vector>
+    Vec2 to_cell(const Vector &point) const;
+
+    /**
+     * 格子中心的世界坐标
+     */
+    Point to_world(const Vec2 &cell) const;
+
+    /**
+     * 清空保存的障碍物，不修改地图
+     */
+    void clear();
+
+    /**
+     * 添加障碍物，不修改地图，之后调用 build 生效
+     */
+    void add_polygon(std::vector<Point> polygon);
+
+    /**
+     * 按保存的障碍物重建地图
+     */
+    void build(GridMap &grid, uint16_t width, uint16_t height);
+
+    /**
+     * 读取 RVOSimulator 中的障碍物并重建地图，要求调用过 processObstacles
+     */
+    template<typename Simulator>
+    void build_from_simulator(GridMap &grid, uint16_t width, uint16_t height, const Simulator &simulator);
+
+    /**
+     * 新增障碍物，只重新栅格化它的包围盒，out_changed 不为空时输出可通过性变化的格子
+     */
+    void add_obstacle(GridMap &grid, std::vector<Point> polygon, std::vector<Vec2> *out_changed);
+
+    /**
+     * 新增障碍物，顶点类型提供 x() 和 y()，例如 RVO::Vector2
+     */
+    template<typename Vector>
+    void add_obstacle(GridMap &grid, const std::vector<Vector> &polygon, std::vector<Vec2> *out_changed);
+
+private:
+    /**
+     * 障碍物及其膨胀前的包围盒
+     */
+    struct Polygon
+    {
+        std::vector<Point>  points;
+        Point               min;
+        Point               max;
+    };
+
+    /**
+     * 格子范围，包含两端
+     */
+    struct CellBox
+    {
+        int     min_x;
+        int     min_y;
+        int     max_x;
+        int     max_y;
+    };
+
+    /**
+     * 障碍物膨胀后的包围盒覆盖的格子，与地图没有交集时返回false
+     */
+    bool get_cell_box(const Polygon &polygon, CellBox *out_box) const;
+
+    /**
+     * 点是否在障碍物内或者距离不超过膨胀半径
+     */
+    bool is_blocked(const Polygon &polygon, const Point &point) const;
+
+private:
+    float                   origin_x_;
+    float                   origin_y_;
+    float                   cell_size_;
+    float                   inflation_;
+    uint16_t                width_;         // 上次重建时的地图尺寸
+    uint16_t                height_;
+    std::vector<Polygon>    polygons_;
+};
+
+// 世界坐标转换为所在的格子
+template<typename Vector>
+GridRaster::Vec2 GridRaster::to_cell(const Vector &point) const
+{
+    Vec2 cell;
+    to_cell(point.x(), point.y(), &cell);
+    return cell;
+}
+
+// 读取 RVOSimulator 中的障碍物并重建地图
+// 障碍物的顶点按 next 连成环，processObstacles 拆分的边只是多出共线的顶点
+template<typename Simulator>
+void GridRaster::build_from_simulator(GridMap &grid, uint16_t width, uint16_t height, const Simulator &simulator)
+{
+    clear();
+    const size_t count = simulator.getNumObstacleVertices();
+    std::vector<bool> visited(count, false);
+    for (size_t first = 0; first < count; ++first)
+    {
+        std::vector<Point> polygon;
+        size_t vertex = first;
+        while (!visited[vertex])
+        {
+            visited[vertex] = true;
+            polygon.push_back({ simulator.getObstacleVertex(vertex).x(), simulator.getObstacleVertex(vertex).y() });
+            vertex = simulator.getNextObstacleVertexNo(vertex);
+        }
+        if (!polygon.empty())
+        {
+            add_polygon(std::move(polygon));
+        }
+    }
+    build(grid, width, height);
+}
+
+// 新增障碍物
+template<typename Vector>
+void GridRaster::add_obstacle(GridMap &grid, const std::vector<Vector> &polygon, std::vector<Vec2> *out_changed)
+{
+    std::vector<Point> points;
+    points.reserve(polygon.size());
+    for (const Vector &point : polygon)
+    {
+        points.push_back({ point.x(), point.y() });
+    }
+    add_obstacle(grid, std::move(points), out_changed);
+}
+
+#endif
@@ -0,0 +1,532 @@
+#include "hpastar.h"
+#include "gridmap.h"
+#include <algorithm>
+
+/**
+ * 簇内寻路使用的地图，坐标相对于簇的左上角，簇外的格子不可通过
+ */
+struct ClusterGrid
+{
+    const GridMap&  map;
+    int             x;
+    int             y;
+    int             width;
+    int             height;
+
+    bool inside(int col, int row) const
+    {
+        return col >= 0 && col < width && row >= 0 && row < height;
+    }
+
+    bool can_pass(const AStar::Vec2 &pos) const
+    {
+        return inside(pos.x, pos.y) && map.can_pass(x + pos.x, y + pos.y);
+    }
+
+    uint8_t get_neighbour_mask(const AStar::Vec2 &pos) const
+    {
+        uint8_t mask = map.get_neighbour_mask(AStar::Vec2(x + pos.x, y + pos.y));
+        if (pos.x == 0 || pos.y == 0 || pos.x + 1 == width || pos.y + 1 == height)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                if (!inside(pos.x + AStar::kNeighbourX[i], pos.y + AStar::kNeighbourY[i]))
+                {
+                    mask &= ~(uint8_t(1) << i);
+                }
+            }
+        }
+        return mask;
+    }
+};
+
+HPAStar::HPAStar()
+    : map_(nullptr)
+    , corner_(false)
+    , cluster_size_(kDefaultClusterSize)
+    , columns_(0)
+    , node_count_(0)
+    , generation_(0)
+    , direct_cost_(kUnreachable)
+    , expanded_(0)
+{
+}
+
+// 建立抽象图
+void HPAStar::build(const GridMap &map, bool corner, int cluster_size)
+{
+    map_ = &map;
+    corner_ = corner;
+    cluster_size_ = cluster_size;
+    columns_ = (map.get_width() + cluster_size - 1) / cluster_size;
+    const int rows = (map.get_height() + cluster_size - 1) / cluster_size;
+
+    clusters_.clear();
+    clusters_.resize(size_t(columns_) * rows);
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int col = 0; col < columns_; ++col)
+        {
+            Cluster &cluster = clusters_[size_t(row) * columns_ + col];
+            cluster.x = col * cluster_size;
+            cluster.y = row * cluster_size;
+            cluster.width = std::min(cluster_size, map.get_width() - cluster.x);
+            cluster.height = std::min(cluster_size, map.get_height() - cluster.y);
+        }
+    }
+
+    for (uint32_t i = 0; i < clusters_.size(); ++i)
+    {
+        rebuild_cluster(i);
+    }
+    update_node_ids();
+}
+
+// 格子发生变化
+void HPAStar::update(const Vec2 &pos)
+{
+    if (map_ == nullptr || pos.x >= map_->get_width() || pos.y >= map_->get_height())
+    {
+        return;
+    }
+
+    // 位于簇边界上的格子还会影响相邻簇的入口
+    uint32_t affected[3];
+    int count = 0;
+    affected[count++] = cluster_of(pos.x, pos.y);
+    if (pos.x % cluster_size_ == 0 && pos.x > 0)
+    {
+        affected[count++] = cluster_of(pos.x - 1, pos.y);
+    }
+    else if ((pos.x + 1) % cluster_size_ == 0 && pos.x + 1 < map_->get_width())
+    {
+        affected[count++] = cluster_of(pos.x + 1, pos.y);
+    }
+    if (pos.y % cluster_size_ == 0 && pos.y > 0)
+    {
+        affected[count++] = cluster_of(pos.x, pos.y - 1);
+    }
+    else if ((pos.y + 1) % cluster_size_ == 0 && pos.y + 1 < map_->get_height())
+    {
+        affected[count++] = cluster_of(pos.x, pos.y + 1);
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        rebuild_cluster(affected[i]);
+    }
+    update_node_ids();
+}
+
+// 格子所在的簇
+uint32_t HPAStar::cluster_of(int x, int y) const
+{
+    return uint32_t(y / cluster_size_) * columns_ + x / cluster_size_;
+}
+
+// 重建簇
+void HPAStar::rebuild_cluster(uint32_t index)
+{
+    Cluster &cluster = clusters_[index];
+    cluster.nodes.clear();
+
+    const int right = cluster.x + cluster.width - 1;
+    const int bottom = cluster.y + cluster.height - 1;
+    if (cluster.y > 0)
+    {
+        add_entrance_nodes(cluster, cluster.x, cluster.y, 1, 0, 0, -1, cluster.width);
+    }
+    if (bottom + 1 < map_->get_height())
+    {
+        add_entrance_nodes(cluster, cluster.x, bottom, 1, 0, 0, 1, cluster.width);
+    }
+    if (cluster.x > 0)
+    {
+        add_entrance_nodes(cluster, cluster.x, cluster.y, 0, 1, -1, 0, cluster.height);
+    }
+    if (right + 1 < map_->get_width())
+    {
+        add_entrance_nodes(cluster, right, cluster.y, 0, 1, 1, 0, cluster.height);
+    }
+
+    // 从每个节点出发在簇内扩散一次，得到到其余节点的代价
+    const size_t size = cluster.nodes.size();
+    cluster.costs.assign(size * size, kUnreachable);
+    for (size_t i = 0; i < size; ++i)
+    {
+        flood_cluster(cluster, cluster.nodes[i]);
+        for (size_t j = 0; j < size; ++j)
+        {
+            const Vec2 &pos = cluster.nodes[j];
+            cluster.costs[i * size + j] = distances_[(pos.y - cluster.y) * cluster_size_ + pos.x - cluster.x];
+        }
+    }
+}
+
+// 在簇内从起点扩散，计算到簇内各格子的代价
+void HPAStar::flood_cluster(const Cluster &cluster, const Vec2 &source)
+{
+    const ClusterGrid grid = { *map_, cluster.x, cluster.y, cluster.width, cluster.height };
+    const size_t size = size_t(cluster_size_) * cluster_size_;
+    distances_.assign(size, kUnreachable);
+    flood_list_.reset(size);
+
+    const uint32_t start = (source.y - cluster.y) * cluster_size_ + source.x - cluster.x;
+    distances_[start] = 0;
+    flood_list_.push(start, 0, 0);
+    while (!flood_list_.empty())
+    {
+        const uint32_t current = flood_list_.pop();
+        const Vec2 pos(current % cluster_size_, current / cluster_size_);
+        unsigned int mask = grid.get_neighbour_mask(pos);
+        if (!corner_)
+        {
+            mask &= AStar::kStraightMask;
+        }
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            const uint32_t next = (pos.y + AStar::kNeighbourY[i]) * cluster_size_ + pos.x + AStar::kNeighbourX[i];
+            const uint32_t distance = distances_[current]
+                + ((i & 1) ? algorithm_.get_oblique_value() : algorithm_.get_step_value());
+            if (distances_[next] == kUnreachable)
+            {
+                distances_[next] = distance;
+                flood_list_.push(next, distance, distance);
+            }
+            else if (distance < distances_[next])
+            {
+                // 已经取出的格子代价不会再变小
+                distances_[next] = distance;
+                flood_list_.decrease(next, distance, distance);
+            }
+        }
+    }
+}
+
+// 查找边界上的入口
+// 两侧都可通过的连续格子为一个入口，较窄的入口取中间，较宽的入口取两端。
+// 相邻簇扫描的是同一条边界，得到的节点两两相对
+void HPAStar::add_entrance_nodes(Cluster &cluster, int x, int y, int dx, int dy, int ox, int oy, int length)
+{
+    auto add_node = [&](int i)
+    {
+        const Vec2 pos(x + dx * i, y + dy * i);
+        if (std::find(cluster.nodes.begin(), cluster.nodes.end(), pos) == cluster.nodes.end())
+        {
+            cluster.nodes.push_back(pos);
+        }
+    };
+
+    int run = 0;
+    for (int i = 0; i <= length; ++i)
+    {
+        const int cx = x + dx * i;
+        const int cy = y + dy * i;
+        if (i < length && map_->can_pass(cx, cy) && map_->can_pass(cx + ox, cy + oy))
+        {
+            ++run;
+            continue;
+        }
+
+        if (run >= kMaxEntranceWidth)
+        {
+            add_node(i - run);
+            add_node(i - 1);
+        }
+        else if (run > 0)
+        {
+            add_node(i - run + (run - 1) / 2);
+        }
+        run = 0;
+    }
+}
+
+// 重新为节点编号
+void HPAStar::update_node_ids()
+{
+    node_count_ = 0;
+    for (Cluster &cluster : clusters_)
+    {
+        cluster.first = node_count_;
+        node_count_ += cluster.nodes.size();
+    }
+
+    owners_.resize(node_count_);
+    for (uint32_t i = 0; i < clusters_.size(); ++i)
+    {
+        const Cluster &cluster = clusters_[i];
+        std::fill_n(owners_.begin() + cluster.first, cluster.nodes.size(), i);
+    }
+
+    const size_t size = node_count_ + 2;
+    g_.resize(size);
+    parent_.resize(size);
+    states_.assign(size, 0);
+    generation_ = 0;
+    open_list_.reset(size);
+}
+
+// 在簇内寻路
+std::vector<HPAStar::Vec2> HPAStar::find_in_cluster(const Cluster &cluster, const Vec2 &from, const Vec2 &to)
+{
+    // 节点表按簇的大小分配，与地图大小无关
+    ClusterGrid grid = { *map_, cluster.x, cluster.y, cluster.width, cluster.height };
+    AStar::Params param;
+    param.width = cluster_size_;
+    param.height = cluster_size_;
+    param.corner = corner_;
+    param.start = Vec2(from.x - cluster.x, from.y - cluster.y);
+    param.end = Vec2(to.x - cluster.x, to.y - cluster.y);
+
+    std::vector<Vec2> paths = algorithm_.find(param, grid);
+    for (Vec2 &pos : paths)
+    {
+        pos.reset(pos.x + cluster.x, pos.y + cluster.y);
+    }
+    return paths;
+}
+
+// 计算H值，与簇内代价的计算方式一致
+uint32_t HPAStar::calcul_h_value(const Vec2 &current, const Vec2 &end) const
+{
+    const int dx = abs(end.x - current.x);
+    const int dy = abs(end.y - current.y);
+    if (!corner_)
+    {
+        return (dx + dy) * algorithm_.get_step_value();
+    }
+    const int oblique = std::min(dx, dy);
+    return oblique * algorithm_.get_oblique_value() + (std::max(dx, dy) - oblique) * algorithm_.get_step_value();
+}
+
+// 抽象节点的坐标
+HPAStar::Vec2 HPAStar::get_node_pos(uint32_t id) const
+{
+    if (id == node_count_)
+    {
+        return start_;
+    }
+    if (id == node_count_ + 1)
+    {
+        return end_;
+    }
+    const Cluster &cluster = clusters_[owners_[id]];
+    return cluster.nodes[id - cluster.first];
+}
+
+// 查找格子对应的抽象节点编号
+uint32_t HPAStar::find_node(const Vec2 &pos) const
+{
+    const Cluster &cluster = clusters_[cluster_of(pos.x, pos.y)];
+    auto iter = std::find(cluster.nodes.begin(), cluster.nodes.end(), pos);
+    if (iter == cluster.nodes.end())
+    {
+        return kUnreachable;
+    }
+    return cluster.first + uint32_t(iter - cluster.nodes.begin());
+}
+
+// 松弛抽象图上的边
+void HPAStar::relax(uint32_t from, uint32_t to, uint32_t cost, const Vec2 &end)
+{
+    if (cost == kUnreachable || states_[to] == generation_ + 1)
+    {
+        return;
+    }
+
+    const uint32_t g_value = g_[from] + cost;
+    if (states_[to] == generation_)
+    {
+        if (g_value < g_[to])
+        {
+            g_[to] = g_value;
+            parent_[to] = from;
+            open_list_.decrease(to, g_value + calcul_h_value(get_node_pos(to), end), g_value);
+        }
+        return;
+    }
+
+    g_[to] = g_value;
+    parent_[to] = from;
+    states_[to] = generation_;
+    open_list_.push(to, g_value + calcul_h_value(get_node_pos(to), end), g_value);
+}
+
+// 在抽象图上寻路
+bool HPAStar::find_abstract(const Vec2 &start, const Vec2 &end, std::vector<Vec2> *out_nodes)
+{
+    out_nodes->clear();
+    expanded_ = 0;
+    assert(map_ != nullptr);
+    if (map_ == nullptr
+        || start.x >= map_->get_width() || start.y >= map_->get_height()
+        || end.x >= map_->get_width() || end.y >= map_->get_height()
+        || !map_->can_pass(start) || !map_->can_pass(end))
+    {
+        return false;
+    }
+
+    // 起点和终点临时接入所在的簇
+    start_ = start;
+    end_ = end;
+    const uint32_t start_id = node_count_;
+    const uint32_t end_id = node_count_ + 1;
+    const uint32_t start_cluster = cluster_of(start.x, start.y);
+    const uint32_t end_cluster = cluster_of(end.x, end.y);
+
+    auto cell_of = [this](const Cluster &cluster, const Vec2 &pos)
+    {
+        return (pos.y - cluster.y) * cluster_size_ + pos.x - cluster.x;
+    };
+
+    const Cluster &from = clusters_[start_cluster];
+    flood_cluster(from, start);
+    start_costs_.resize(from.nodes.size());
+    for (size_t i = 0; i < from.nodes.size(); ++i)
+    {
+        start_costs_[i] = distances_[cell_of(from, from.nodes[i])];
+    }
+    direct_cost_ = start_cluster == end_cluster ? distances_[cell_of(from, end)] : kUnreachable;
+
+    // 簇内代价对称，从终点扩散即可
+    const Cluster &to = clusters_[end_cluster];
+    flood_cluster(to, end);
+    end_costs_.resize(to.nodes.size());
+    for (size_t i = 0; i < to.nodes.size(); ++i)
+    {
+        end_costs_[i] = distances_[cell_of(to, to.nodes[i])];
+    }
+
+    // 新的搜索代数
+    generation_ += 2;
+    if (generation_ < 2)
+    {
+        std::fill(states_.begin(), states_.end(), 0);
+        generation_ = 2;
+    }
+    open_list_.clear();
+
+    g_[start_id] = 0;
+    parent_[start_id] = kUnreachable;
+    states_[start_id] = generation_;
+    open_list_.push(start_id, calcul_h_value(start, end), 0);
+
+    while (!open_list_.empty())
+    {
+        const uint32_t current = open_list_.pop();
+        if (states_[current] != generation_)
+        {
+            continue;
+        }
+        states_[current] = generation_ + 1;
+        ++expanded_;
+
+        if (current == end_id)
+        {
+            for (uint32_t id = end_id; id != kUnreachable; id = parent_[id])
+            {
+                const Vec2 pos = get_node_pos(id);
+                if (out_nodes->empty() || !(out_nodes->back() == pos))
+                {
+                    out_nodes->push_back(pos);
+                }
+            }
+            std::reverse(out_nodes->begin(), out_nodes->end());
+            return true;
+        }
+
+        if (current == start_id)
+        {
+            for (size_t i = 0; i < from.nodes.size(); ++i)
+            {
+                relax(current, from.first + i, start_costs_[i], end);
+            }
+            relax(current, end_id, direct_cost_, end);
+            continue;
+        }
+
+        // 簇内的边
+        const uint32_t owner = owners_[current];
+        const Cluster &cluster = clusters_[owner];
+        const size_t local = current - cluster.first;
+        const size_t size = cluster.nodes.size();
+        for (size_t j = 0; j < size; ++j)
+        {
+            if (j != local)
+            {
+                relax(current, cluster.first + j, cluster.costs[local * size + j], end);
+            }
+        }
+        if (owner == end_cluster)
+        {
+            relax(current, end_id, end_costs_[local], end);
+        }
+
+        // 跨越簇边界的边
+        const Vec2 pos = cluster.nodes[local];
+        for (int i = 0; i < 8; i += 2)
+        {
+            const int x = pos.x + AStar::kNeighbourX[i];
+            const int y = pos.y + AStar::kNeighbourY[i];
+            if (x < 0 || x >= map_->get_width() || y < 0 || y >= map_->get_height() || cluster_of(x, y) == owner)
+            {
+                continue;
+            }
+            const uint32_t neighbour = find_node(Vec2(x, y));
+            if (neighbour != kUnreachable)
+            {
+                relax(current, neighbour, algorithm_.get_step_value(), end);
+            }
+        }
+    }
+    return false;
+}
+
+// 细化相邻的两个抽象节点
+std::vector<HPAStar::Vec2> HPAStar::refine(const Vec2 &from, const Vec2 &to)
+{
+    if (from == to)
+    {
+        return std::vector<Vec2>();
+    }
+
+    const uint32_t cluster = cluster_of(from.x, from.y);
+    if (cluster != cluster_of(to.x, to.y))
+    {
+        // 跨越簇边界的一步
+        return std::vector<Vec2>(1, to);
+    }
+    return find_in_cluster(clusters_[cluster], from, to);
+}
+
+// 执行寻路操作
+std::vector<HPAStar::Vec2> HPAStar::find(const Vec2 &start, const Vec2 &end)
+{
+    std::vector<Vec2> paths;
+    std::vector<Vec2> nodes;
+    if (!find_abstract(start, end, &nodes))
+    {
+        return paths;
+    }
+
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        const std::vector<Vec2> segment = refine(nodes[i - 1], nodes[i]);
+        paths.insert(paths.end(), segment.begin(), segment.end());
+    }
+    return paths;
+}
+
+// 获取上次寻路扩展的抽象节点数
+size_t HPAStar::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 获取抽象节点总数
+size_t HPAStar::get_node_count() const
+{
+    return node_count_;
+}
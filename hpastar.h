@@ -0,0 +1,157 @@
+#ifndef __HPASTAR_H__
+#define __HPASTAR_H__
+
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+#include "openlist.h"
+
+class GridMap;
+
+/**
+ * 分层寻路(HPA*)
+ * 地图划分为固定大小的簇，相邻簇的公共边界上连续可通过的格子形成入口，
+ * 入口两侧的格子作为抽象节点，簇内节点之间的代价由簇内扩散预计算。
+ * 寻路时先在抽象图上搜索，再按需用 AStar 把相邻的抽象节点细化为格子路径，
+ * 地图修改后只需重建受影响的簇
+ */
+class HPAStar
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    static const int kDefaultClusterSize = 16;
+    static const int kMaxEntranceWidth = 6;         // 入口宽度达到该值时在两端各放一个节点
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+public:
+    HPAStar();
+
+public:
+    /**
+     * 为地图建立抽象图，地图需要在使用期间保持有效
+     */
+    void build(const GridMap &map, bool corner, int cluster_size = kDefaultClusterSize);
+
+    /**
+     * 地图上的格子发生变化，重建受影响的簇
+     */
+    void update(const Vec2 &pos);
+
+    /**
+     * 在抽象图上寻路，输出依次经过的抽象节点，包含起点和终点
+     */
+    bool find_abstract(const Vec2 &start, const Vec2 &end, std::vector<Vec2> *out_nodes);
+
+    /**
+     * 细化抽象路径上相邻的两个节点，返回不含起点的格子路径
+     */
+    std::vector<Vec2> refine(const Vec2 &from, const Vec2 &to);
+
+    /**
+     * 执行寻路操作，返回不含起点的格子路径，与 AStar::find 一致
+     */
+    std::vector<Vec2> find(const Vec2 &start, const Vec2 &end);
+
+    /**
+     * 获取上次寻路扩展的抽象节点数
+     */
+    size_t get_expanded_count() const;
+
+    /**
+     * 获取抽象节点总数
+     */
+    size_t get_node_count() const;
+
+private:
+    /**
+     * 簇
+     */
+    struct Cluster
+    {
+        uint16_t                x;          // 左上角坐标
+        uint16_t                y;
+        uint16_t                width;
+        uint16_t                height;
+        uint32_t                first;      // 第一个节点的编号
+        std::vector<Vec2>       nodes;      // 抽象节点
+        std::vector<uint32_t>   costs;      // 节点之间的代价，nodes.size()^2
+    };
+
+    /**
+     * 格子所在的簇
+     */
+    uint32_t cluster_of(int x, int y) const;
+
+    /**
+     * 重建簇的抽象节点和簇内代价
+     */
+    void rebuild_cluster(uint32_t index);
+
+    /**
+     * 沿簇的一条边界查找入口，(x, y)为边界起点，(dx, dy)为边界方向，(ox, oy)指向相邻簇
+     */
+    void add_entrance_nodes(Cluster &cluster, int x, int y, int dx, int dy, int ox, int oy, int length);
+
+    /**
+     * 重新为节点编号
+     */
+    void update_node_ids();
+
+    /**
+     * 在簇内寻路
+     */
+    std::vector<Vec2> find_in_cluster(const Cluster &cluster, const Vec2 &from, const Vec2 &to);
+
+    /**
+     * 在簇内从起点扩散，结果存放在distances_中，不可到达为kUnreachable
+     */
+    void flood_cluster(const Cluster &cluster, const Vec2 &source);
+
+    /**
+     * 计算H值
+     */
+    uint32_t calcul_h_value(const Vec2 &current, const Vec2 &end) const;
+
+    /**
+     * 抽象节点的坐标
+     */
+    Vec2 get_node_pos(uint32_t id) const;
+
+    /**
+     * 查找格子对应的抽象节点编号
+     */
+    uint32_t find_node(const Vec2 &pos) const;
+
+    /**
+     * 松弛抽象图上的边
+     */
+    void relax(uint32_t from, uint32_t to, uint32_t cost, const Vec2 &end);
+
+private:
+    const GridMap*          map_;
+    bool                    corner_;
+    int                     cluster_size_;
+    int                     columns_;       // 每行的簇数
+    std::vector<Cluster>    clusters_;
+    std::vector<uint32_t>   owners_;        // 节点所在的簇
+    std::vector<uint32_t>   distances_;     // 簇内扩散的结果，按簇内坐标存放
+    BinaryHeap              flood_list_;
+    uint32_t                node_count_;
+    AStar                   algorithm_;
+
+    // 抽象图搜索状态，起点和终点使用最后两个编号
+    std::vector<uint32_t>   g_;
+    std::vector<uint32_t>   parent_;
+    std::vector<uint32_t>   states_;        // 等于generation_为开启，加一为关闭
+    uint32_t                generation_;
+    BinaryHeap              open_list_;
+    std::vector<uint32_t>   start_costs_;   // 起点到所在簇各节点的代价
+    std::vector<uint32_t>   end_costs_;     // 终点所在簇各节点到终点的代价
+    uint32_t                direct_cost_;   // 起点和终点在同一簇时的簇内代价
+    Vec2                    start_;
+    Vec2                    end_;
+    size_t                  expanded_;
+};
+
+#endif
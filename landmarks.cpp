@@ -0,0 +1,333 @@
+#include "landmarks.h"
+#include "gridmap.h"
+#include "openlist.h"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    // 文件头，数据按本机字节序存放
+    struct FileHeader
+    {
+        char        magic[4];
+        uint32_t    version;
+        uint16_t    width;
+        uint16_t    height;
+        uint32_t    count;
+        uint32_t    corner;
+        int32_t     step_value;
+        int32_t     oblique_value;
+        uint64_t    map_hash;
+    };
+
+    const char kMagic[4] = { 'A', 'L', 'T', 'L' };
+    const uint32_t kVersion = 1;
+}
+
+Landmarks::Landmarks()
+    : width_(0)
+    , height_(0)
+    , corner_(false)
+    , step_val_(AStar::kStepValue)
+    , oblique_val_(AStar::kObliqueValue)
+    , revision_(0)
+    , map_hash_(0)
+{
+}
+
+// 选出路标并计算代价
+// 第一个路标取最大连通区域中离任意起点最远的格子，之后每次取离已有路标最近距离最大的格子，
+// 路标分散在地图的边缘和死路的尽头，下界更紧
+void Landmarks::build(const GridMap &map, int count, bool corner)
+{
+    clear();
+    width_ = map.get_width();
+    height_ = map.get_height();
+    corner_ = corner;
+    step_val_ = AStar::kStepValue;
+    oblique_val_ = AStar::kObliqueValue;
+    revision_ = map.get_revision();
+    map_hash_ = map.get_hash();
+
+    const size_t size = size_t(width_) * height_;
+    if (count <= 0 || size == 0)
+    {
+        return;
+    }
+    count = std::min(count, kMaxCount);
+
+    // 找出最大的连通区域，斜向移动要求两侧的直行格子可通过，按四方向划分即可
+    std::vector<uint8_t> visited(size, 0);
+    std::vector<uint32_t> stack;
+    uint32_t seed = kUnreachable;
+    size_t largest = 0;
+    for (uint32_t start = 0; start < size; ++start)
+    {
+        if (visited[start] || !map.can_pass(start % width_, start / width_))
+        {
+            continue;
+        }
+        size_t area = 0;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            const uint32_t current = stack.back();
+            stack.pop_back();
+            ++area;
+            const int x = current % width_;
+            const int y = current / width_;
+            for (int i = 0; i < 8; i += 2)
+            {
+                const int nx = x + AStar::kNeighbourX[i];
+                const int ny = y + AStar::kNeighbourY[i];
+                const uint32_t neighbour = uint32_t(ny) * width_ + nx;
+                if (map.can_pass(nx, ny) && !visited[neighbour])
+                {
+                    visited[neighbour] = 1;
+                    stack.push_back(neighbour);
+                }
+            }
+        }
+        if (area > largest)
+        {
+            largest = area;
+            seed = start;
+        }
+    }
+    if (seed == kUnreachable)
+    {
+        return;
+    }
+
+    // 离已有路标的最近代价，不可到达的格子不参与选择
+    std::vector<uint32_t> nearest(size);
+    calcul_distances(map, seed, nearest.data());
+
+    distances_.reserve(size * count);
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t farthest = kUnreachable;
+        uint32_t farthest_distance = 0;
+        for (uint32_t index = 0; index < size; ++index)
+        {
+            if (nearest[index] != kUnreachable && (farthest == kUnreachable || nearest[index] > farthest_distance))
+            {
+                farthest = index;
+                farthest_distance = nearest[index];
+            }
+        }
+
+        // 剩下的格子都已经是路标
+        if (i > 0 && farthest_distance == 0)
+        {
+            break;
+        }
+
+        landmarks_.push_back(farthest);
+        distances_.resize(size * landmarks_.size());
+        uint32_t *distances = distances_.data() + size * (landmarks_.size() - 1);
+        calcul_distances(map, farthest, distances);
+        for (size_t index = 0; index < size; ++index)
+        {
+            nearest[index] = i == 0 ? distances[index] : std::min(nearest[index], distances[index]);
+        }
+    }
+}
+
+// 保存到文件
+bool Landmarks::save(const char *filename) const
+{
+    std::FILE *file = std::fopen(filename, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.width = width_;
+    header.height = height_;
+    header.count = uint32_t(landmarks_.size());
+    header.corner = corner_ ? 1 : 0;
+    header.step_value = step_val_;
+    header.oblique_value = oblique_val_;
+    header.map_hash = map_hash_;
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(landmarks_.data(), sizeof(uint32_t), landmarks_.size(), file) == landmarks_.size();
+    ok = ok && std::fwrite(distances_.data(), sizeof(uint32_t), distances_.size(), file) == distances_.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+// 从文件载入
+bool Landmarks::load(const char *filename, const GridMap &map)
+{
+    std::FILE *file = std::fopen(filename, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // 先取得文件长度，文件头中的路标数通过检查后才分配内存
+    long length = -1;
+    if (std::fseek(file, 0, SEEK_END) == 0)
+    {
+        length = std::ftell(file);
+    }
+    FileHeader header;
+    bool ok = length >= long(sizeof(header))
+        && std::fseek(file, 0, SEEK_SET) == 0
+        && std::fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+        && header.version == kVersion
+        && header.width == map.get_width()
+        && header.height == map.get_height()
+        && header.count <= uint32_t(kMaxCount)
+        && header.corner <= 1
+        && header.step_value == AStar::kStepValue
+        && header.oblique_value == AStar::kObliqueValue
+        && header.map_hash == map.get_hash();
+
+    // 路标数不超过上限，长度的计算不会溢出
+    const size_t size = size_t(header.width) * header.height;
+    ok = ok && size_t(length) == sizeof(header) + size_t(header.count) * (1 + size) * sizeof(uint32_t);
+    std::vector<uint32_t> landmarks;
+    std::vector<uint32_t> distances;
+    if (ok)
+    {
+        landmarks.resize(header.count);
+        distances.resize(size * header.count);
+        ok = std::fread(landmarks.data(), sizeof(uint32_t), landmarks.size(), file) == landmarks.size()
+            && std::fread(distances.data(), sizeof(uint32_t), distances.size(), file) == distances.size()
+            && std::all_of(landmarks.begin(), landmarks.end(), [&](uint32_t index) { return index < size; });
+    }
+    std::fclose(file);
+    if (!ok)
+    {
+        return false;
+    }
+
+    width_ = header.width;
+    height_ = header.height;
+    corner_ = header.corner != 0;
+    step_val_ = header.step_value;
+    oblique_val_ = header.oblique_value;
+    revision_ = map.get_revision();
+    map_hash_ = header.map_hash;
+    landmarks_ = std::move(landmarks);
+    distances_ = std::move(distances);
+    return true;
+}
+
+// 清空路标
+void Landmarks::clear()
+{
+    landmarks_.clear();
+    distances_.clear();
+}
+
+// 获取路标数
+int Landmarks::get_count() const
+{
+    return int(landmarks_.size());
+}
+
+// 获取路标所在的格子索引
+uint32_t Landmarks::get_landmark(int index) const
+{
+    return landmarks_[index];
+}
+
+// 获取地图宽度
+uint16_t Landmarks::get_width() const
+{
+    return width_;
+}
+
+// 获取地图高度
+uint16_t Landmarks::get_height() const
+{
+    return height_;
+}
+
+// 代价是否按8方向移动计算
+bool Landmarks::is_corner() const
+{
+    return corner_;
+}
+
+// 获取直行代价
+int Landmarks::get_step_value() const
+{
+    return step_val_;
+}
+
+// 获取斜向代价
+int Landmarks::get_oblique_value() const
+{
+    return oblique_val_;
+}
+
+// 获取生成或载入时的地图版本
+uint64_t Landmarks::get_revision() const
+{
+    return revision_;
+}
+
+// 获取占用的内存
+size_t Landmarks::get_memory_usage() const
+{
+    return landmarks_.capacity() * sizeof(uint32_t) + distances_.capacity() * sizeof(uint32_t);
+}
+
+// 从格子出发计算到所有格子的代价(Dijkstra)
+void Landmarks::calcul_distances(const GridMap &map, uint32_t source, uint32_t *out_distances) const
+{
+    const size_t size = size_t(width_) * height_;
+    std::fill(out_distances, out_distances + size, kUnreachable);
+    std::vector<uint8_t> queued(size, 0);
+    BinaryHeap open_list;
+    open_list.reset(size);
+
+    out_distances[source] = 0;
+    queued[source] = 1;
+    open_list.push(source, 0, 0);
+    while (!open_list.empty())
+    {
+        const uint32_t current = open_list.pop();
+        queued[current] = 0;
+
+        const AStar::Vec2 pos(current % width_, current / width_);
+        unsigned int mask = map.get_neighbour_mask(pos);
+        if (!corner_)
+        {
+            mask &= AStar::kStraightMask;
+        }
+        while (mask != 0)
+        {
+            const int i = std::countr_zero(mask);
+            mask &= mask - 1;
+            const uint32_t neighbour = uint32_t(pos.y + AStar::kNeighbourY[i]) * width_ + pos.x + AStar::kNeighbourX[i];
+            const uint32_t distance = out_distances[current] + ((i & 1) ? oblique_val_ : step_val_);
+            if (distance < out_distances[neighbour])
+            {
+                out_distances[neighbour] = distance;
+                if (queued[neighbour])
+                {
+                    open_list.decrease(neighbour, distance, distance);
+                }
+                else
+                {
+                    queued[neighbour] = 1;
+                    open_list.push(neighbour, distance, distance);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef __LANDMARKS_H__
+#define __LANDMARKS_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class GridMap;
+
+/**
+ * ALT 路标
+ * 预先选出若干路标格子，保存每个路标到所有格子的准确代价，
+ * 由三角不等式 |d(L, a) - d(L, b)| <= d(a, b) 得到两点之间代价的下界。
+ * 在有死路的迷宫里几何距离严重低估代价，用下界作为 AStar 的启发函数可以大幅减少扩展的节点。
+ * 代价与 AStar 相同，直行为10，斜向为14，斜向移动要求两侧的直行格子可通过。
+ * 每个路标一个连续的数组，按 y*width+x 存放，与 AStar 的节点索引一致
+ */
+class Landmarks
+{
+public:
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+    static constexpr int kMaxCount = 256;       // 路标数上限，载入文件时同样检查
+
+public:
+    Landmarks();
+
+public:
+    /**
+     * 选出 count 个路标并计算代价，最多 kMaxCount 个，corner 为 true 时代价按8方向移动计算，
+     * 同时适用于允许和不允许拐角的寻路
+     */
+    void build(const GridMap &map, int count, bool corner);
+
+    /**
+     * 保存到文件，失败返回false
+     */
+    bool save(const char *filename) const;
+
+    /**
+     * 从文件载入，文件损坏或者与地图的内容不一致时返回false，原有数据保持不变
+     */
+    bool load(const char *filename, const GridMap &map);
+
+    /**
+     * 清空路标
+     */
+    void clear();
+
+    /**
+     * 获取路标数
+     */
+    int get_count() const;
+
+    /**
+     * 获取路标所在的格子索引
+     */
+    uint32_t get_landmark(int index) const;
+
+    /**
+     * 获取地图宽度
+     */
+    uint16_t get_width() const;
+
+    /**
+     * 获取地图高度
+     */
+    uint16_t get_height() const;
+
+    /**
+     * 代价是否按8方向移动计算
+     */
+    bool is_corner() const;
+
+    /**
+     * 获取直行代价
+     */
+    int get_step_value() const;
+
+    /**
+     * 获取斜向代价
+     */
+    int get_oblique_value() const;
+
+    /**
+     * 获取生成或载入时的地图版本，地图修改之后下界可能不再成立
+     */
+    uint64_t get_revision() const;
+
+    /**
+     * 获取占用的内存
+     */
+    size_t get_memory_usage() const;
+
+    /**
+     * 获取两个格子之间代价的下界，参数为格子索引
+     */
+    uint32_t get_lower_bound(uint32_t from, uint32_t to) const;
+
+    /**
+     * 获取所有路标到格子的代价，out_distances 的长度为路标数
+     */
+    void get_distances(uint32_t index, uint32_t *out_distances) const;
+
+    /**
+     * 获取格子到终点代价的下界，to_distances 为 get_distances 得到的终点代价，
+     * 同一终点多次查询时省去读取终点的代价
+     */
+    uint32_t get_lower_bound(uint32_t from, const uint32_t *to_distances) const;
+
+private:
+    /**
+     * 从格子出发计算到所有格子的代价
+     */
+    void calcul_distances(const GridMap &map, uint32_t source, uint32_t *out_distances) const;
+
+private:
+    uint16_t                width_;
+    uint16_t                height_;
+    bool                    corner_;
+    int                     step_val_;
+    int                     oblique_val_;
+    uint64_t                revision_;
+    uint64_t                map_hash_;
+    std::vector<uint32_t>   landmarks_;     // 路标所在的格子索引
+    std::vector<uint32_t>   distances_;     // 每个路标 width*height 个代价，依次存放
+};
+
+// 获取两个格子之间代价的下界
+inline uint32_t Landmarks::get_lower_bound(uint32_t from, uint32_t to) const
+{
+    const size_t size = size_t(width_) * height_;
+    const uint32_t *distances = distances_.data();
+    uint32_t bound = 0;
+    for (size_t i = 0; i < landmarks_.size(); ++i, distances += size)
+    {
+        const uint32_t a = distances[from];
+        const uint32_t b = distances[to];
+        if (a != kUnreachable && b != kUnreachable)
+        {
+            const uint32_t difference = a > b ? a - b : b - a;
+            bound = difference > bound ? difference : bound;
+        }
+    }
+    return bound;
+}
+
+// 获取所有路标到格子的代价
+inline void Landmarks::get_distances(uint32_t index, uint32_t *out_distances) const
+{
+    const size_t size = size_t(width_) * height_;
+    for (size_t i = 0; i < landmarks_.size(); ++i)
+    {
+        out_distances[i] = distances_[i * size + index];
+    }
+}
+
+// 获取格子到终点代价的下界
+inline uint32_t Landmarks::get_lower_bound(uint32_t from, const uint32_t *to_distances) const
+{
+    const size_t size = size_t(width_) * height_;
+    const uint32_t *distances = distances_.data();
+    uint32_t bound = 0;
+    for (size_t i = 0; i < landmarks_.size(); ++i, distances += size)
+    {
+        const uint32_t a = distances[from];
+        const uint32_t b = to_distances[i];
+        if (a != kUnreachable && b != kUnreachable)
+        {
+            const uint32_t difference = a > b ? a - b : b - a;
+            bound = difference > bound ? difference : bound;
+        }
+    }
+    return bound;
+}
+
+#endif
@@ -13,7 +13,7 @@
 #include <imgui_sdl.h>
 
 #include "astar.h"
-#include "blockallocator.h"
+#include "gridmap.h"
 
 using namespace std;
 
@@ -193,16 +193,13 @@ struct Simulation
       param.corner = false;
       param.start = AStar::Vec2(0, 0);
       param.end = AStar::Vec2(9, 9);
-      param.can_pass = [&](const AStar::Vec2 &pos) -> bool
-      {
-          return maps[pos.y][pos.x] == 0;
-      };
+      GridMap grid(param.width, param.height);
+      grid.assign(&maps[0][0], 0);
 
       // 执行搜索
-      BlockAllocator allocator;
-      AStar algorithm(&allocator);
+      AStar algorithm;
       // 得到每一步的 goal
-      std::vector<AStar::Vec2> path = algorithm.find(param);
+      std::vector<AStar::Vec2> path = algorithm.find(param, grid);
       for(int i = 0; i < path.size(); ++i) {
         cout << path[i].x << " " << path[i].y << endl;
       }
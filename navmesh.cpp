@@ -0,0 +1,1133 @@
+#include "navmesh.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    const float kCostScale = 100.0f;    // 开启列表的键值为整数，代价乘以该值取整
+
+    /**
+     * 约束 Delaunay 三角剖分
+     * 从矩形的两个三角形开始逐点插入并翻转边保持 Delaunay，
+     * 再翻转与约束边相交的边直到约束边出现(Sloan)，最后翻转不满足 Delaunay 的非约束边。
+     * 插入的约束边不能相交，也不能经过其他顶点，由调用方预先切分
+     */
+    class Triangulation
+    {
+    public:
+        struct Vertex
+        {
+            double      x;
+            double      y;
+        };
+
+        struct Face
+        {
+            int         vertices[3];
+            int         neighbours[3];
+            bool        constrained[3];
+        };
+
+    public:
+        Triangulation(double min_x, double min_y, double max_x, double max_y)
+            : min_x_(min_x)
+            , min_y_(min_y)
+            , max_x_(max_x)
+            , max_y_(max_y)
+        {
+            const double size = std::max(max_x - min_x, max_y - min_y);
+            epsilon_ = size * 1e-6;
+            circle_epsilon_ = size * size * size * size * 1e-12;
+            vertices_ = { { min_x, min_y }, { max_x, min_y }, { max_x, max_y }, { min_x, max_y } };
+            faces_.push_back({ { 0, 1, 2 }, { -1, -1, 1 }, { false, false, false } });
+            faces_.push_back({ { 0, 2, 3 }, { 0, -1, -1 }, { false, false, false } });
+        }
+
+        const std::vector<Vertex>& get_vertices() const
+        {
+            return vertices_;
+        }
+
+        const std::vector<Face>& get_faces() const
+        {
+            return faces_;
+        }
+
+        double get_epsilon() const
+        {
+            return epsilon_;
+        }
+
+        // 插入顶点，与已有顶点重合时返回已有顶点，靠近矩形边界的坐标对齐到边界
+        int insert(double x, double y)
+        {
+            x = snap(x, min_x_, max_x_);
+            y = snap(y, min_y_, max_y_);
+            for (size_t i = 0; i < vertices_.size(); ++i)
+            {
+                if (std::abs(vertices_[i].x - x) <= epsilon_ && std::abs(vertices_[i].y - y) <= epsilon_)
+                {
+                    return int(i);
+                }
+            }
+
+            const Vertex point = { x, y };
+            for (size_t face = 0; face < faces_.size(); ++face)
+            {
+                int on_edge = -1;
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; ++i)
+                {
+                    const Vertex &a = vertices_[faces_[face].vertices[i]];
+                    const Vertex &b = vertices_[faces_[face].vertices[(i + 1) % 3]];
+                    const double distance = orient(a, b, point) / std::hypot(b.x - a.x, b.y - a.y);
+                    if (distance < -epsilon_)
+                    {
+                        inside = false;
+                    }
+                    else if (distance <= epsilon_)
+                    {
+                        on_edge = i;
+                    }
+                }
+                if (inside)
+                {
+                    vertices_.push_back(point);
+                    const int vertex = int(vertices_.size() - 1);
+                    if (on_edge >= 0)
+                    {
+                        split_edge(int(face), on_edge, vertex);
+                    }
+                    else
+                    {
+                        split_face(int(face), vertex);
+                    }
+                    return vertex;
+                }
+            }
+            return -1;
+        }
+
+        // 插入约束边，翻转与它相交的边
+        void insert_constraint(int a, int b)
+        {
+            if (a == b || a < 0 || b < 0)
+            {
+                return;
+            }
+
+            std::vector<std::pair<int, int>> crossing;
+            for (size_t face = 0; face < faces_.size(); ++face)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    const int p = faces_[face].vertices[i];
+                    const int q = faces_[face].vertices[(i + 1) % 3];
+                    if (faces_[face].neighbours[i] > int(face) && is_crossing(p, q, a, b))
+                    {
+                        crossing.emplace_back(p, q);
+                    }
+                }
+            }
+
+            // 凹四边形的边暂时不能翻转，放回队尾等相邻的边翻转之后再处理
+            size_t guard = crossing.size() * crossing.size() + 16;
+            while (!crossing.empty() && guard-- > 0)
+            {
+                const auto [p, q] = crossing.front();
+                crossing.erase(crossing.begin());
+                int face = 0;
+                int edge = 0;
+                if (!find_edge(p, q, &face, &edge) || faces_[face].constrained[edge])
+                {
+                    continue;
+                }
+                const int c = faces_[face].vertices[(edge + 2) % 3];
+                const int d = get_opposite(face, edge);
+                if (!is_crossing(c, d, p, q))
+                {
+                    crossing.emplace_back(p, q);
+                    continue;
+                }
+                flip(face, edge);
+                if (c != a && c != b && d != a && d != b && is_crossing(c, d, a, b))
+                {
+                    crossing.emplace_back(c, d);
+                }
+            }
+
+            int face = 0;
+            int edge = 0;
+            if (find_edge(a, b, &face, &edge) || find_edge(b, a, &face, &edge))
+            {
+                faces_[face].constrained[edge] = true;
+                const int neighbour = faces_[face].neighbours[edge];
+                if (neighbour >= 0)
+                {
+                    faces_[neighbour].constrained[edge_to(neighbour, face)] = true;
+                }
+            }
+        }
+
+        // 翻转不满足 Delaunay 的非约束边直到全部满足
+        void restore_delaunay()
+        {
+            bool changed = true;
+            size_t guard = faces_.size() * faces_.size() + 16;
+            while (changed && guard-- > 0)
+            {
+                changed = false;
+                for (size_t face = 0; face < faces_.size(); ++face)
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        if (should_flip(int(face), i))
+                        {
+                            flip(int(face), i);
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        static double orient(const Vertex &a, const Vertex &b, const Vertex &c)
+        {
+            return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        }
+
+        double snap(double value, double min, double max) const
+        {
+            if (std::abs(value - min) <= epsilon_)
+            {
+                return min;
+            }
+            if (std::abs(value - max) <= epsilon_)
+            {
+                return max;
+            }
+            return value;
+        }
+
+        // 线段 pq 与 ab 是否在内部相交
+        bool is_crossing(int p, int q, int a, int b) const
+        {
+            const Vertex &vp = vertices_[p];
+            const Vertex &vq = vertices_[q];
+            const Vertex &va = vertices_[a];
+            const Vertex &vb = vertices_[b];
+            const double tolerance = epsilon_ * epsilon_;
+            const double o1 = orient(va, vb, vp);
+            const double o2 = orient(va, vb, vq);
+            const double o3 = orient(vp, vq, va);
+            const double o4 = orient(vp, vq, vb);
+            return ((o1 > tolerance && o2 < -tolerance) || (o1 < -tolerance && o2 > tolerance))
+                && ((o3 > tolerance && o4 < -tolerance) || (o3 < -tolerance && o4 > tolerance));
+        }
+
+        // d 是否在逆时针三角形 abc 的外接圆内
+        double in_circle(const Vertex &a, const Vertex &b, const Vertex &c, const Vertex &d) const
+        {
+            const double ax = a.x - d.x, ay = a.y - d.y;
+            const double bx = b.x - d.x, by = b.y - d.y;
+            const double cx = c.x - d.x, cy = c.y - d.y;
+            return (ax * ax + ay * ay) * (bx * cy - cx * by)
+                - (bx * bx + by * by) * (ax * cy - cx * ay)
+                + (cx * cx + cy * cy) * (ax * by - bx * ay);
+        }
+
+        bool should_flip(int face, int edge) const
+        {
+            const Face &f = faces_[face];
+            if (f.neighbours[edge] < 0 || f.constrained[edge])
+            {
+                return false;
+            }
+            const int a = f.vertices[edge];
+            const int b = f.vertices[(edge + 1) % 3];
+            const int c = f.vertices[(edge + 2) % 3];
+            const int d = get_opposite(face, edge);
+            return in_circle(vertices_[a], vertices_[b], vertices_[c], vertices_[d]) > circle_epsilon_
+                && is_crossing(c, d, a, b);
+        }
+
+        // 边另一侧三角形中与边相对的顶点
+        int get_opposite(int face, int edge) const
+        {
+            const int neighbour = faces_[face].neighbours[edge];
+            const int index = edge_to(neighbour, face);
+            return faces_[neighbour].vertices[(index + 2) % 3];
+        }
+
+        // 三角形中与相邻三角形共用的边
+        int edge_to(int face, int neighbour) const
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                if (faces_[face].neighbours[i] == neighbour)
+                {
+                    return i;
+                }
+            }
+            assert(false);
+            return 0;
+        }
+
+        bool find_edge(int a, int b, int *out_face, int *out_edge) const
+        {
+            for (size_t face = 0; face < faces_.size(); ++face)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    if (faces_[face].vertices[i] == a && faces_[face].vertices[(i + 1) % 3] == b)
+                    {
+                        *out_face = int(face);
+                        *out_edge = i;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void replace_neighbour(int face, int from, int to)
+        {
+            if (face >= 0)
+            {
+                faces_[face].neighbours[edge_to(face, from)] = to;
+            }
+        }
+
+        // 边 edge 的两端为 a、b，对面的顶点为 c，另一侧三角形对面的顶点为 d，翻转为 cd
+        // 翻转后 face 为 (a, d, c)，neighbour 为 (d, b, c)，两者的第0条边是原来四边形的外边
+        void flip(int face, int edge)
+        {
+            const Face t = faces_[face];
+            const int neighbour = t.neighbours[edge];
+            const int index = edge_to(neighbour, face);
+            const Face u = faces_[neighbour];
+
+            const int a = t.vertices[edge];
+            const int b = t.vertices[(edge + 1) % 3];
+            const int c = t.vertices[(edge + 2) % 3];
+            const int d = u.vertices[(index + 2) % 3];
+            const int bc = t.neighbours[(edge + 1) % 3];
+            const int ca = t.neighbours[(edge + 2) % 3];
+            const int ad = u.neighbours[(index + 1) % 3];
+            const int db = u.neighbours[(index + 2) % 3];
+
+            faces_[face] = { { a, d, c }, { ad, neighbour, ca }, { u.constrained[(index + 1) % 3], false, t.constrained[(edge + 2) % 3] } };
+            faces_[neighbour] = { { d, b, c }, { db, bc, face }, { u.constrained[(index + 2) % 3], t.constrained[(edge + 1) % 3], false } };
+            replace_neighbour(ad, neighbour, face);
+            replace_neighbour(bc, face, neighbour);
+        }
+
+        void legalize(int face, int edge)
+        {
+            std::vector<std::pair<int, int>> stack = { { face, edge } };
+            while (!stack.empty())
+            {
+                const auto [current, index] = stack.back();
+                stack.pop_back();
+                if (should_flip(current, index))
+                {
+                    const int neighbour = faces_[current].neighbours[index];
+                    flip(current, index);
+                    stack.emplace_back(current, 0);
+                    stack.emplace_back(neighbour, 0);
+                }
+            }
+        }
+
+        // 点在三角形内部，分成三个三角形，新三角形的第0条边为原来的边
+        void split_face(int face, int p)
+        {
+            const Face t = faces_[face];
+            const int a = t.vertices[0];
+            const int b = t.vertices[1];
+            const int c = t.vertices[2];
+            const int second = int(faces_.size());
+            const int third = second + 1;
+            faces_[face] = { { a, b, p }, { t.neighbours[0], second, third }, { t.constrained[0], false, false } };
+            faces_.push_back({ { b, c, p }, { t.neighbours[1], third, face }, { t.constrained[1], false, false } });
+            faces_.push_back({ { c, a, p }, { t.neighbours[2], face, second }, { t.constrained[2], false, false } });
+            replace_neighbour(t.neighbours[1], face, second);
+            replace_neighbour(t.neighbours[2], face, third);
+            legalize(face, 0);
+            legalize(second, 0);
+            legalize(third, 0);
+        }
+
+        // 点在边上，边两侧的三角形各分成两个
+        void split_edge(int face, int edge, int p)
+        {
+            const Face t = faces_[face];
+            const int a = t.vertices[edge];
+            const int b = t.vertices[(edge + 1) % 3];
+            const int c = t.vertices[(edge + 2) % 3];
+            const int bc = t.neighbours[(edge + 1) % 3];
+            const int ca = t.neighbours[(edge + 2) % 3];
+            const int neighbour = t.neighbours[edge];
+            const int second = int(faces_.size());
+            const int fourth = neighbour >= 0 ? second + 1 : -1;
+
+            faces_[face] = { { c, a, p }, { ca, neighbour, second }, { t.constrained[(edge + 2) % 3], t.constrained[edge], false } };
+            faces_.push_back({ { b, c, p }, { bc, face, fourth }, { t.constrained[(edge + 1) % 3], false, t.constrained[edge] } });
+            replace_neighbour(bc, face, second);
+
+            if (neighbour >= 0)
+            {
+                const Face u = faces_[neighbour];
+                const int index = edge_to(neighbour, face);
+                const int d = u.vertices[(index + 2) % 3];
+                const int ad = u.neighbours[(index + 1) % 3];
+                const int db = u.neighbours[(index + 2) % 3];
+                faces_[neighbour] = { { a, d, p }, { ad, fourth, face }, { u.constrained[(index + 1) % 3], false, u.constrained[index] } };
+                faces_.push_back({ { d, b, p }, { db, second, neighbour }, { u.constrained[(index + 2) % 3], u.constrained[index], false } });
+                replace_neighbour(db, neighbour, fourth);
+                legalize(neighbour, 0);
+                legalize(fourth, 0);
+            }
+            legalize(face, 0);
+            legalize(second, 0);
+        }
+
+    private:
+        double                  min_x_;
+        double                  min_y_;
+        double                  max_x_;
+        double                  max_y_;
+        double                  epsilon_;
+        double                  circle_epsilon_;
+        std::vector<Vertex>     vertices_;
+        std::vector<Face>       faces_;
+    };
+
+    // 线段裁剪到矩形内(Liang-Barsky)
+    bool clip_segment(double min_x, double min_y, double max_x, double max_y,
+                      double *x0, double *y0, double *x1, double *y1)
+    {
+        const double dx = *x1 - *x0;
+        const double dy = *y1 - *y0;
+        const double p[4] = { -dx, dx, -dy, dy };
+        const double q[4] = { *x0 - min_x, max_x - *x0, *y0 - min_y, max_y - *y0 };
+        double t0 = 0.0;
+        double t1 = 1.0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (p[i] == 0.0)
+            {
+                if (q[i] < 0.0)
+                {
+                    return false;
+                }
+                continue;
+            }
+            const double t = q[i] / p[i];
+            if (p[i] < 0.0)
+            {
+                t0 = std::max(t0, t);
+            }
+            else
+            {
+                t1 = std::min(t1, t);
+            }
+        }
+        if (t0 > t1)
+        {
+            return false;
+        }
+        const double sx = *x0;
+        const double sy = *y0;
+        *x0 = std::clamp(sx + t0 * dx, min_x, max_x);
+        *y0 = std::clamp(sy + t0 * dy, min_y, max_y);
+        *x1 = std::clamp(sx + t1 * dx, min_x, max_x);
+        *y1 = std::clamp(sy + t1 * dy, min_y, max_y);
+        return true;
+    }
+
+    float orient(const NavMesh::Point &a, const NavMesh::Point &b, const NavMesh::Point &c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    float distance(const NavMesh::Point &a, const NavMesh::Point &b)
+    {
+        return std::hypot(b.x - a.x, b.y - a.y);
+    }
+
+    bool equal(const NavMesh::Point &a, const NavMesh::Point &b)
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+}
+
+NavMesh::NavMesh()
+    : min_x_(0.0f)
+    , min_y_(0.0f)
+    , tile_size_(1.0f)
+    , columns_(0)
+    , rows_(0)
+    , rebuilt_(0)
+    , generation_(0)
+    , dirty_(true)
+    , expanded_(0)
+{
+}
+
+// 设置地图范围和块的边长
+void NavMesh::set_bounds(float min_x, float min_y, float max_x, float max_y, float tile_size)
+{
+    assert(tile_size > 0.0f && max_x > min_x && max_y > min_y);
+    min_x_ = min_x;
+    min_y_ = min_y;
+    tile_size_ = tile_size;
+    columns_ = std::max(1, int(std::ceil((max_x - min_x) / tile_size)));
+    rows_ = std::max(1, int(std::ceil((max_y - min_y) / tile_size)));
+
+    // 相邻块的公共边界用同一个表达式计算，两侧的坐标完全相等
+    tiles_.assign(size_t(columns_) * rows_, Tile());
+    for (int row = 0; row < rows_; ++row)
+    {
+        for (int col = 0; col < columns_; ++col)
+        {
+            Tile &tile = tiles_[size_t(row) * columns_ + col];
+            tile.min_x = min_x + col * tile_size;
+            tile.min_y = min_y + row * tile_size;
+            tile.max_x = col + 1 == columns_ ? max_x : min_x + (col + 1) * tile_size;
+            tile.max_y = row + 1 == rows_ ? max_y : min_y + (row + 1) * tile_size;
+        }
+    }
+    dirty_ = true;
+}
+
+// 清空保存的障碍物
+void NavMesh::clear()
+{
+    obstacles_.clear();
+}
+
+// 添加障碍物
+int NavMesh::add_polygon(std::vector<Point> points)
+{
+    assert(!points.empty());
+    Obstacle obstacle;
+    obstacle.min = points.front();
+    obstacle.max = points.front();
+    for (const Point &point : points)
+    {
+        obstacle.min.x = std::min(obstacle.min.x, point.x);
+        obstacle.min.y = std::min(obstacle.min.y, point.y);
+        obstacle.max.x = std::max(obstacle.max.x, point.x);
+        obstacle.max.y = std::max(obstacle.max.y, point.y);
+    }
+    obstacle.points = std::move(points);
+    obstacles_.push_back(std::move(obstacle));
+    return int(obstacles_.size() - 1);
+}
+
+// 重建所有块
+void NavMesh::build()
+{
+    for (size_t i = 0; i < tiles_.size(); ++i)
+    {
+        rebuild_tile(int(i));
+    }
+    rebuilt_ = tiles_.size();
+    dirty_ = true;
+}
+
+// 新增障碍物
+int NavMesh::add_obstacle(std::vector<Point> points)
+{
+    const int id = add_polygon(std::move(points));
+    rebuild_tiles(obstacles_[id].min, obstacles_[id].max);
+    return id;
+}
+
+// 删除障碍物
+bool NavMesh::remove_obstacle(int id)
+{
+    if (id < 0 || size_t(id) >= obstacles_.size() || obstacles_[id].points.empty())
+    {
+        return false;
+    }
+    obstacles_[id].points.clear();
+    rebuild_tiles(obstacles_[id].min, obstacles_[id].max);
+    return true;
+}
+
+// 寻路
+// 在三角形上做 A*，记录进入每个三角形时经过的边，找到终点后按边拉直路径
+bool NavMesh::find(const Point &start, const Point &end, float radius, std::vector<Point> *out_waypoints)
+{
+    out_waypoints->clear();
+    expanded_ = 0;
+    const int start_tile = find_tile(start);
+    const int end_tile = find_tile(end);
+    if (start_tile < 0 || end_tile < 0)
+    {
+        return false;
+    }
+    const int start_triangle = find_triangle(tiles_[start_tile], start);
+    const int end_triangle = find_triangle(tiles_[end_tile], end);
+    if (start_triangle < 0 || end_triangle < 0)
+    {
+        return false;
+    }
+
+    // 网格变化后三角形重新编号
+    if (dirty_)
+    {
+        tile_offsets_.assign(1, 0);
+        for (const Tile &tile : tiles_)
+        {
+            tile_offsets_.push_back(tile_offsets_.back() + uint32_t(tile.triangles.size()));
+        }
+        const size_t size = tile_offsets_.back();
+        g_.resize(size);
+        parent_.resize(size);
+        parent_portals_.resize(size);
+        states_.assign(size, 0);
+        generation_ = 0;
+        open_list_.reset(size);
+        dirty_ = false;
+    }
+
+    const uint32_t start_id = tile_offsets_[start_tile] + start_triangle;
+    const uint32_t end_id = tile_offsets_[end_tile] + end_triangle;
+
+    // 新的搜索代数
+    generation_ += 2;
+    if (generation_ < 2)
+    {
+        std::fill(states_.begin(), states_.end(), 0);
+        generation_ = 2;
+    }
+    open_list_.clear();
+
+    g_[start_id] = 0.0f;
+    parent_[start_id] = UINT32_MAX;
+    parent_portals_[start_id] = { start, start };
+    states_[start_id] = generation_;
+    open_list_.push(start_id, uint32_t(distance(start, end) * kCostScale), 0);
+
+    while (!open_list_.empty())
+    {
+        const uint32_t current = open_list_.pop();
+        if (states_[current] != generation_)
+        {
+            continue;
+        }
+        states_[current] = generation_ + 1;
+        ++expanded_;
+
+        if (current == end_id)
+        {
+            std::vector<Portal> portals;
+            portals.push_back({ end, end });
+            for (uint32_t id = end_id; id != start_id; id = parent_[id])
+            {
+                portals.push_back(parent_portals_[id]);
+            }
+            portals.push_back({ start, start });
+            std::reverse(portals.begin(), portals.end());
+            string_pull(portals, radius, out_waypoints);
+            return true;
+        }
+
+        const int tile_index = int(std::upper_bound(tile_offsets_.begin(), tile_offsets_.end(), current) - tile_offsets_.begin()) - 1;
+        const Tile &tile = tiles_[tile_index];
+        const Triangle &triangle = tile.triangles[current - tile_offsets_[tile_index]];
+        const Point &v0 = tile.vertices[triangle.vertices[0]];
+        const Point &v1 = tile.vertices[triangle.vertices[1]];
+        const Point &v2 = tile.vertices[triangle.vertices[2]];
+        const Point center = { (v0.x + v1.x + v2.x) / 3.0f, (v0.y + v1.y + v2.y) / 3.0f };
+        for (int i = 0; i < 3; ++i)
+        {
+            if (triangle.constrained[i])
+            {
+                continue;
+            }
+            const Point &a = tile.vertices[triangle.vertices[i]];
+            const Point &b = tile.vertices[triangle.vertices[(i + 1) % 3]];
+            if (triangle.neighbours[i] >= 0)
+            {
+                if (!tile.triangles[triangle.neighbours[i]].blocked)
+                {
+                    relax(current, tile_offsets_[tile_index] + triangle.neighbours[i], { b, a }, end);
+                }
+                continue;
+            }
+
+            // 块边界上的边，与相邻块边界上重叠的边相连
+            int side = -1;
+            if (a.x == tile.max_x && b.x == tile.max_x)
+            {
+                side = 0;
+            }
+            else if (a.y == tile.max_y && b.y == tile.max_y)
+            {
+                side = 1;
+            }
+            else if (a.x == tile.min_x && b.x == tile.min_x)
+            {
+                side = 2;
+            }
+            else if (a.y == tile.min_y && b.y == tile.min_y)
+            {
+                side = 3;
+            }
+            const int col = tile_index % columns_ + (side == 0) - (side == 2);
+            const int row = tile_index / columns_ + (side == 1) - (side == 3);
+            if (side < 0 || col < 0 || col >= columns_ || row < 0 || row >= rows_)
+            {
+                continue;
+            }
+
+            const int other_index = row * columns_ + col;
+            const bool vertical = (side & 1) == 0;
+            const float from = vertical ? std::min(a.y, b.y) : std::min(a.x, b.x);
+            const float to = vertical ? std::max(a.y, b.y) : std::max(a.x, b.x);
+            const float line = vertical ? a.x : a.y;
+            for (const BorderEdge &border : tiles_[other_index].borders[(side + 2) % 4])
+            {
+                if (border.from >= to)
+                {
+                    break;
+                }
+                const float low = std::max(from, border.from);
+                const float high = std::min(to, border.to);
+                if (high <= low)
+                {
+                    continue;
+                }
+                Point left = vertical ? Point{ line, low } : Point{ low, line };
+                Point right = vertical ? Point{ line, high } : Point{ high, line };
+                if (orient(center, right, left) < 0.0f)
+                {
+                    std::swap(left, right);
+                }
+                relax(current, tile_offsets_[other_index] + border.triangle, { left, right }, end);
+            }
+        }
+    }
+    return false;
+}
+
+// 获取上次寻路扩展的三角形数
+size_t NavMesh::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 获取三角形总数
+size_t NavMesh::get_triangle_count() const
+{
+    size_t count = 0;
+    for (const Tile &tile : tiles_)
+    {
+        count += tile.triangles.size();
+    }
+    return count;
+}
+
+// 获取块数
+size_t NavMesh::get_tile_count() const
+{
+    return tiles_.size();
+}
+
+// 获取最近一次修改重建的块数
+size_t NavMesh::get_rebuilt_count() const
+{
+    return rebuilt_;
+}
+
+// 重建与包围盒相交的块，正好落在块边界上的障碍物两侧的块都要重建
+void NavMesh::rebuild_tiles(const Point &min, const Point &max)
+{
+    const int min_col = std::max(0, int(std::floor((min.x - min_x_) / tile_size_)) - 1);
+    const int min_row = std::max(0, int(std::floor((min.y - min_y_) / tile_size_)) - 1);
+    const int max_col = std::min(columns_ - 1, int(std::floor((max.x - min_x_) / tile_size_)) + 1);
+    const int max_row = std::min(rows_ - 1, int(std::floor((max.y - min_y_) / tile_size_)) + 1);
+    rebuilt_ = 0;
+    for (int row = min_row; row <= max_row; ++row)
+    {
+        for (int col = min_col; col <= max_col; ++col)
+        {
+            const Tile &tile = tiles_[size_t(row) * columns_ + col];
+            if (tile.min_x <= max.x && tile.max_x >= min.x && tile.min_y <= max.y && tile.max_y >= min.y)
+            {
+                rebuild_tile(row * columns_ + col);
+                ++rebuilt_;
+            }
+        }
+    }
+    dirty_ = true;
+}
+
+// 重建块
+// 障碍物的边裁剪到块内，在交点和经过的顶点处切分后作为约束边
+void NavMesh::rebuild_tile(int index)
+{
+    Tile &tile = tiles_[index];
+    Triangulation triangulation(tile.min_x, tile.min_y, tile.max_x, tile.max_y);
+    const double epsilon = triangulation.get_epsilon();
+
+    struct Segment
+    {
+        double  x0;
+        double  y0;
+        double  x1;
+        double  y1;
+    };
+    std::vector<const Obstacle*> nearby;
+    std::vector<Segment> segments;
+    for (const Obstacle &obstacle : obstacles_)
+    {
+        if (obstacle.points.empty()
+            || obstacle.min.x > tile.max_x || obstacle.max.x < tile.min_x
+            || obstacle.min.y > tile.max_y || obstacle.max.y < tile.min_y)
+        {
+            continue;
+        }
+        nearby.push_back(&obstacle);
+        const size_t count = obstacle.points.size();
+        const size_t edges = count > 2 ? count : count - 1;
+        for (size_t i = 0; i < edges; ++i)
+        {
+            const Point &a = obstacle.points[i];
+            const Point &b = obstacle.points[(i + 1) % count];
+            Segment segment = { a.x, a.y, b.x, b.y };
+            if (clip_segment(tile.min_x, tile.min_y, tile.max_x, tile.max_y, &segment.x0, &segment.y0, &segment.x1, &segment.y1)
+                && std::hypot(segment.x1 - segment.x0, segment.y1 - segment.y0) > epsilon)
+            {
+                segments.push_back(segment);
+            }
+        }
+    }
+
+    // 端点和两两之间的交点
+    std::vector<Triangulation::Vertex> points;
+    for (const Segment &segment : segments)
+    {
+        points.push_back({ segment.x0, segment.y0 });
+        points.push_back({ segment.x1, segment.y1 });
+    }
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const Segment &s = segments[i];
+        for (size_t j = i + 1; j < segments.size(); ++j)
+        {
+            const Segment &t = segments[j];
+            const double rx = s.x1 - s.x0, ry = s.y1 - s.y0;
+            const double sx = t.x1 - t.x0, sy = t.y1 - t.y0;
+            const double denominator = rx * sy - ry * sx;
+            if (std::abs(denominator) <= epsilon * epsilon)
+            {
+                continue;
+            }
+            const double u = ((t.x0 - s.x0) * sy - (t.y0 - s.y0) * sx) / denominator;
+            const double v = ((t.x0 - s.x0) * ry - (t.y0 - s.y0) * rx) / denominator;
+            if (u > 0.0 && u < 1.0 && v > 0.0 && v < 1.0)
+            {
+                points.push_back({ s.x0 + u * rx, s.y0 + u * ry });
+            }
+        }
+    }
+    for (const Triangulation::Vertex &point : points)
+    {
+        triangulation.insert(point.x, point.y);
+    }
+
+    // 每条边按经过的点切分，共线重叠的边切分后成为同一条约束边
+    for (const Segment &segment : segments)
+    {
+        const double dx = segment.x1 - segment.x0;
+        const double dy = segment.y1 - segment.y0;
+        const double length = std::hypot(dx, dy);
+        std::vector<double> cuts = { 0.0, 1.0 };
+        for (const Triangulation::Vertex &point : triangulation.get_vertices())
+        {
+            const double t = ((point.x - segment.x0) * dx + (point.y - segment.y0) * dy) / (length * length);
+            const double offset = std::abs((point.x - segment.x0) * dy - (point.y - segment.y0) * dx) / length;
+            if (offset <= epsilon && t * length > epsilon && (1.0 - t) * length > epsilon)
+            {
+                cuts.push_back(t);
+            }
+        }
+        std::sort(cuts.begin(), cuts.end());
+        for (size_t i = 1; i < cuts.size(); ++i)
+        {
+            const int a = triangulation.insert(segment.x0 + cuts[i - 1] * dx, segment.y0 + cuts[i - 1] * dy);
+            const int b = triangulation.insert(segment.x0 + cuts[i] * dx, segment.y0 + cuts[i] * dy);
+            triangulation.insert_constraint(a, b);
+        }
+    }
+    triangulation.restore_delaunay();
+
+    tile.vertices.clear();
+    for (const Triangulation::Vertex &vertex : triangulation.get_vertices())
+    {
+        tile.vertices.push_back({ float(vertex.x), float(vertex.y) });
+    }
+    tile.triangles.clear();
+    for (const Triangulation::Face &face : triangulation.get_faces())
+    {
+        Triangle triangle;
+        for (int i = 0; i < 3; ++i)
+        {
+            triangle.vertices[i] = uint32_t(face.vertices[i]);
+            triangle.neighbours[i] = face.neighbours[i];
+            triangle.constrained[i] = face.constrained[i];
+        }
+        const Point &a = tile.vertices[triangle.vertices[0]];
+        const Point &b = tile.vertices[triangle.vertices[1]];
+        const Point &c = tile.vertices[triangle.vertices[2]];
+        const Point center = { (a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f };
+        triangle.blocked = std::any_of(nearby.begin(), nearby.end(), [&](const Obstacle *obstacle)
+        {
+            return is_inside(*obstacle, center);
+        });
+        tile.triangles.push_back(triangle);
+    }
+
+    // 边界上可通过的边
+    for (std::vector<BorderEdge> &borders : tile.borders)
+    {
+        borders.clear();
+    }
+    for (uint32_t i = 0; i < tile.triangles.size(); ++i)
+    {
+        const Triangle &triangle = tile.triangles[i];
+        for (int k = 0; k < 3; ++k)
+        {
+            if (triangle.blocked || triangle.neighbours[k] >= 0 || triangle.constrained[k])
+            {
+                continue;
+            }
+            const Point &a = tile.vertices[triangle.vertices[k]];
+            const Point &b = tile.vertices[triangle.vertices[(k + 1) % 3]];
+            if (a.x == tile.max_x && b.x == tile.max_x)
+            {
+                tile.borders[0].push_back({ std::min(a.y, b.y), std::max(a.y, b.y), i });
+            }
+            else if (a.y == tile.max_y && b.y == tile.max_y)
+            {
+                tile.borders[1].push_back({ std::min(a.x, b.x), std::max(a.x, b.x), i });
+            }
+            else if (a.x == tile.min_x && b.x == tile.min_x)
+            {
+                tile.borders[2].push_back({ std::min(a.y, b.y), std::max(a.y, b.y), i });
+            }
+            else if (a.y == tile.min_y && b.y == tile.min_y)
+            {
+                tile.borders[3].push_back({ std::min(a.x, b.x), std::max(a.x, b.x), i });
+            }
+        }
+    }
+    for (std::vector<BorderEdge> &borders : tile.borders)
+    {
+        std::sort(borders.begin(), borders.end(), [](const BorderEdge &a, const BorderEdge &b) { return a.from < b.from; });
+    }
+}
+
+// 点所在的块
+int NavMesh::find_tile(const Point &point) const
+{
+    if (tiles_.empty())
+    {
+        return -1;
+    }
+    const Tile &last = tiles_.back();
+    if (point.x < min_x_ || point.y < min_y_ || point.x > last.max_x || point.y > last.max_y)
+    {
+        return -1;
+    }
+    const int col = std::min(columns_ - 1, int((point.x - min_x_) / tile_size_));
+    const int row = std::min(rows_ - 1, int((point.y - min_y_) / tile_size_));
+    return row * columns_ + col;
+}
+
+// 点所在的可通过三角形，边上的点也算在内
+int NavMesh::find_triangle(const Tile &tile, const Point &point) const
+{
+    const float tolerance = tile_size_ * 1e-5f;
+    for (size_t i = 0; i < tile.triangles.size(); ++i)
+    {
+        const Triangle &triangle = tile.triangles[i];
+        if (triangle.blocked)
+        {
+            continue;
+        }
+        bool inside = true;
+        for (int k = 0; k < 3 && inside; ++k)
+        {
+            const Point &a = tile.vertices[triangle.vertices[k]];
+            const Point &b = tile.vertices[triangle.vertices[(k + 1) % 3]];
+            inside = orient(a, b, point) >= -tolerance * distance(a, b);
+        }
+        if (inside)
+        {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+// 进入三角形时经过的边的中点，起点所在的三角形为起点
+NavMesh::Point NavMesh::get_entry(uint32_t node) const
+{
+    const Portal &portal = parent_portals_[node];
+    return { (portal.left.x + portal.right.x) * 0.5f, (portal.left.y + portal.right.y) * 0.5f };
+}
+
+// 松弛三角形之间的边
+// 代价为两次经过的边的中点之间的距离，比重心之间的距离更接近拉直后的长度
+void NavMesh::relax(uint32_t from, uint32_t to, const Portal &portal, const Point &end)
+{
+    if (states_[to] == generation_ + 1)
+    {
+        return;
+    }
+
+    const Point entry = { (portal.left.x + portal.right.x) * 0.5f, (portal.left.y + portal.right.y) * 0.5f };
+    const float g_value = g_[from] + distance(get_entry(from), entry);
+    const uint32_t f_key = uint32_t((g_value + distance(entry, end)) * kCostScale);
+    const uint32_t g_key = uint32_t(g_value * kCostScale);
+    if (states_[to] == generation_)
+    {
+        if (g_value < g_[to])
+        {
+            g_[to] = g_value;
+            parent_[to] = from;
+            parent_portals_[to] = portal;
+            open_list_.decrease(to, f_key, g_key);
+        }
+        return;
+    }
+
+    g_[to] = g_value;
+    parent_[to] = from;
+    parent_portals_[to] = portal;
+    states_[to] = generation_;
+    open_list_.push(to, f_key, g_key);
+}
+
+// 漏斗算法拉直路径
+// 漏斗的两条边从顶点出发，逐个经过的边收紧，一侧越过另一侧时该侧的端点成为拐点和新的顶点。
+// 路径绕过拐点时障碍物在拐角的内侧，拐点沿角平分线向外侧偏移 radius
+void NavMesh::string_pull(const std::vector<Portal> &portals, float radius, std::vector<Point> *out_waypoints) const
+{
+    std::vector<Point> corners;
+    Point apex = portals[0].left;
+    Point left = apex;
+    Point right = apex;
+    size_t apex_index = 0;
+    size_t left_index = 0;
+    size_t right_index = 0;
+    for (size_t i = 1; i < portals.size(); ++i)
+    {
+        const Point &next_left = portals[i].left;
+        const Point &next_right = portals[i].right;
+
+        if (orient(apex, right, next_right) >= 0.0f)
+        {
+            if (equal(apex, right) || orient(apex, left, next_right) < 0.0f)
+            {
+                right = next_right;
+                right_index = i;
+            }
+            else
+            {
+                if (corners.empty() || !equal(corners.back(), left))
+                {
+                    corners.push_back(left);
+                }
+                apex = left;
+                apex_index = left_index;
+                right = apex;
+                right_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+
+        if (orient(apex, left, next_left) <= 0.0f)
+        {
+            if (equal(apex, left) || orient(apex, right, next_left) > 0.0f)
+            {
+                left = next_left;
+                left_index = i;
+            }
+            else
+            {
+                if (corners.empty() || !equal(corners.back(), right))
+                {
+                    corners.push_back(right);
+                }
+                apex = right;
+                apex_index = right_index;
+                left = apex;
+                left_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+    }
+
+    const Point &start = portals.front().left;
+    const Point &end = portals.back().left;
+    while (!corners.empty() && equal(corners.back(), end))
+    {
+        corners.pop_back();
+    }
+    for (size_t i = 0; i < corners.size(); ++i)
+    {
+        Point corner = corners[i];
+        const Point &previous = i == 0 ? start : corners[i - 1];
+        const Point &next = i + 1 < corners.size() ? corners[i + 1] : end;
+        const float previous_length = distance(corner, previous);
+        const float next_length = distance(corner, next);
+        if (radius > 0.0f && previous_length > 0.0f && next_length > 0.0f)
+        {
+            const float x = (previous.x - corner.x) / previous_length + (next.x - corner.x) / next_length;
+            const float y = (previous.y - corner.y) / previous_length + (next.y - corner.y) / next_length;
+            const float length = std::hypot(x, y);
+            if (length > 1e-3f)
+            {
+                corner.x -= x / length * radius;
+                corner.y -= y / length * radius;
+            }
+        }
+        out_waypoints->push_back(corner);
+    }
+    out_waypoints->push_back(end);
+}
+
+// 点是否在障碍物内，射线法，与顶点顺序无关
+bool NavMesh::is_inside(const Obstacle &obstacle, const Point &point)
+{
+    const std::vector<Point> &points = obstacle.points;
+    if (points.size() < 3 || point.x < obstacle.min.x || point.x > obstacle.max.x
+        || point.y < obstacle.min.y || point.y > obstacle.max.y)
+    {
+        return false;
+    }
+
+    bool inside = false;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+    {
+        const Point &a = points[j];
+        const Point &b = points[i];
+        if ((a.y > point.y) != (b.y > point.y)
+            && point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
@@ -0,0 +1,257 @@
+#ifndef __NAVMESH_H__
+#define __NAVMESH_H__
+
+#include <vector>
+#include <cstdint>
+#include "openlist.h"
+
+/**
+ * 导航网格
+ * 地图范围划分为固定大小的块，每块对块内的障碍物边做约束 Delaunay 三角剖分，
+ * 中心在障碍物内的三角形不可通过，障碍物的边不可穿过。
+ * 相邻块的三角形通过公共边界上重叠的边相连，增删障碍物时只重建与它的包围盒相交的块。
+ * 寻路时在三角形上做 A*，代价为经过的边的中点之间的距离，再用漏斗算法拉直得到路径点，
+ * 拐点按 Agent 的半径向外偏移，可以直接作为偏好速度的目标。
+ * 障碍物的顶点顺序不限，两个顶点的障碍物按线段处理
+ */
+class NavMesh
+{
+public:
+    /**
+     * 世界坐标
+     */
+    struct Point
+    {
+        float x;
+        float y;
+    };
+
+public:
+    NavMesh();
+
+public:
+    /**
+     * 设置地图范围和块的边长，清空网格，之后调用 build 生效
+     */
+    void set_bounds(float min_x, float min_y, float max_x, float max_y, float tile_size);
+
+    /**
+     * 清空保存的障碍物，不修改网格
+     */
+    void clear();
+
+    /**
+     * 添加障碍物，不修改网格，之后调用 build 生效，返回障碍物编号
+     */
+    int add_polygon(std::vector<Point> polygon);
+
+    /**
+     * 按保存的障碍物重建所有块
+     */
+    void build();
+
+    /**
+     * 读取 RVOSimulator 中的障碍物并重建所有块，要求调用过 processObstacles
+     */
+    template<typename Simulator>
+    void build_from_simulator(const Simulator &simulator);
+
+    /**
+     * 新增障碍物，只重建与它相交的块，返回障碍物编号
+     */
+    int add_obstacle(std::vector<Point> polygon);
+
+    /**
+     * 新增障碍物，顶点类型提供 x() 和 y()，例如 RVO::Vector2
+     */
+    template<typename Vector>
+    int add_obstacle(const std::vector<Vector> &polygon);
+
+    /**
+     * 删除障碍物，只重建与它相交的块，编号无效时返回false
+     */
+    bool remove_obstacle(int id);
+
+    /**
+     * 寻路，输出不含起点的路径点，拐点与障碍物的顶点保持 radius 的距离。
+     * 起点或终点在地图外、在障碍物内或者不可到达时返回false
+     */
+    bool find(const Point &start, const Point &end, float radius, std::vector<Point> *out_waypoints);
+
+    /**
+     * 获取上次寻路扩展的三角形数
+     */
+    size_t get_expanded_count() const;
+
+    /**
+     * 获取三角形总数，包括不可通过的三角形
+     */
+    size_t get_triangle_count() const;
+
+    /**
+     * 获取块数
+     */
+    size_t get_tile_count() const;
+
+    /**
+     * 获取最近一次修改重建的块数
+     */
+    size_t get_rebuilt_count() const;
+
+private:
+    /**
+     * 三角形，顶点按逆时针排列，第i条边从 vertices[i] 到 vertices[(i+1)%3]
+     */
+    struct Triangle
+    {
+        uint32_t    vertices[3];
+        int32_t     neighbours[3];      // 边另一侧的三角形，块的边界为-1
+        bool        constrained[3];     // 是否为障碍物的边
+        bool        blocked;            // 是否在障碍物内
+    };
+
+    /**
+     * 块边界上的边，from < to 为沿边界的坐标
+     */
+    struct BorderEdge
+    {
+        float       from;
+        float       to;
+        uint32_t    triangle;
+    };
+
+    /**
+     * 块
+     */
+    struct Tile
+    {
+        float                   min_x;
+        float                   min_y;
+        float                   max_x;
+        float                   max_y;
+        std::vector<Point>      vertices;
+        std::vector<Triangle>   triangles;
+        std::vector<BorderEdge> borders[4];     // 按右、下、左、上的边界分别存放，按坐标排序
+    };
+
+    /**
+     * 障碍物及其包围盒，删除后顶点为空
+     */
+    struct Obstacle
+    {
+        std::vector<Point>  points;
+        Point               min;
+        Point               max;
+    };
+
+    /**
+     * 寻路经过的边
+     */
+    struct Portal
+    {
+        Point       left;
+        Point       right;
+    };
+
+    /**
+     * 重建与包围盒相交的块
+     */
+    void rebuild_tiles(const Point &min, const Point &max);
+
+    /**
+     * 重建块
+     */
+    void rebuild_tile(int index);
+
+    /**
+     * 点所在的块，超出范围返回-1
+     */
+    int find_tile(const Point &point) const;
+
+    /**
+     * 点所在的可通过三角形，找不到返回-1
+     */
+    int find_triangle(const Tile &tile, const Point &point) const;
+
+    /**
+     * 进入三角形时经过的边的中点
+     */
+    Point get_entry(uint32_t node) const;
+
+    /**
+     * 松弛三角形之间的边
+     */
+    void relax(uint32_t from, uint32_t to, const Portal &portal, const Point &end);
+
+    /**
+     * 漏斗算法拉直路径
+     */
+    void string_pull(const std::vector<Portal> &portals, float radius, std::vector<Point> *out_waypoints) const;
+
+    /**
+     * 点是否在障碍物内
+     */
+    static bool is_inside(const Obstacle &obstacle, const Point &point);
+
+private:
+    float                   min_x_;
+    float                   min_y_;
+    float                   tile_size_;
+    int                     columns_;
+    int                     rows_;
+    std::vector<Tile>       tiles_;
+    std::vector<Obstacle>   obstacles_;
+    size_t                  rebuilt_;
+
+    // 搜索状态，三角形按块依次编号
+    std::vector<uint32_t>   tile_offsets_;
+    std::vector<float>      g_;
+    std::vector<uint32_t>   parent_;
+    std::vector<Portal>     parent_portals_;    // 从父节点进入时经过的边
+    std::vector<uint32_t>   states_;            // 等于generation_为开启，加一为关闭
+    uint32_t                generation_;
+    bool                    dirty_;             // 网格变化后重新编号
+    BinaryHeap              open_list_;
+    size_t                  expanded_;
+};
+
+// 读取 RVOSimulator 中的障碍物并重建所有块
+// 障碍物的顶点按 next 连成环，processObstacles 拆分的边只是多出共线的顶点
+template<typename Simulator>
+void NavMesh::build_from_simulator(const Simulator &simulator)
+{
+    clear();
+    const size_t count = simulator.getNumObstacleVertices();
+    std::vector<bool> visited(count, false);
+    for (size_t first = 0; first < count; ++first)
+    {
+        std::vector<Point> polygon;
+        size_t vertex = first;
+        while (!visited[vertex])
+        {
+            visited[vertex] = true;
+            polygon.push_back({ simulator.getObstacleVertex(vertex).x(), simulator.getObstacleVertex(vertex).y() });
+            vertex = simulator.getNextObstacleVertexNo(vertex);
+        }
+        if (!polygon.empty())
+        {
+            add_polygon(std::move(polygon));
+        }
+    }
+    build();
+}
+
+// 新增障碍物
+template<typename Vector>
+int NavMesh::add_obstacle(const std::vector<Vector> &polygon)
+{
+    std::vector<Point> points;
+    points.reserve(polygon.size());
+    for (const Vector &point : polygon)
+    {
+        points.push_back({ point.x(), point.y() });
+    }
+    return add_obstacle(std::move(points));
+}
+
+#endif
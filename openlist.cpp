@@ -0,0 +1,177 @@
+#include "openlist.h"
+#include <bit>
+#include <cassert>
+
+// 节点索引范围
+void BinaryHeap::reset(size_t size)
+{
+    heap_.clear();
+    position_.resize(size);
+}
+
+// 清空
+void BinaryHeap::clear()
+{
+    heap_.clear();
+}
+
+// 放入节点
+void BinaryHeap::push(uint32_t index, uint32_t f, uint32_t g)
+{
+    heap_.push_back({ make_key(f, g), index });
+    percolate_up(heap_.size() - 1);
+}
+
+// 节点的f值变小
+void BinaryHeap::decrease(uint32_t index, uint32_t f, uint32_t g)
+{
+    const size_t hole = position_[index];
+    assert(hole < heap_.size() && heap_[hole].index == index);
+    heap_[hole].key = make_key(f, g);
+    percolate_up(hole);
+}
+
+// 取出f值最小的节点
+uint32_t BinaryHeap::pop()
+{
+    const uint32_t index = heap_.front().index;
+    const Entry last = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty())
+    {
+        heap_[0] = last;
+        percolate_down(0);
+    }
+    return index;
+}
+
+// 上滤
+void BinaryHeap::percolate_up(size_t hole)
+{
+    const Entry entry = heap_[hole];
+    while (hole > 0)
+    {
+        size_t parent = (hole - 1) / 2;
+        if (entry.key < heap_[parent].key)
+        {
+            heap_[hole] = heap_[parent];
+            position_[heap_[hole].index] = hole;
+            hole = parent;
+        }
+        else
+        {
+            break;
+        }
+    }
+    heap_[hole] = entry;
+    position_[entry.index] = hole;
+}
+
+// 下滤
+void BinaryHeap::percolate_down(size_t hole)
+{
+    const Entry entry = heap_[hole];
+    const size_t size = heap_.size();
+    while (true)
+    {
+        size_t child = hole * 2 + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && heap_[child + 1].key < heap_[child].key)
+        {
+            ++child;
+        }
+        if (heap_[child].key < entry.key)
+        {
+            heap_[hole] = heap_[child];
+            position_[heap_[hole].index] = hole;
+            hole = child;
+        }
+        else
+        {
+            break;
+        }
+    }
+    heap_[hole] = entry;
+    position_[entry.index] = hole;
+}
+
+RadixHeap::RadixHeap()
+    : last_(0)
+    , size_(0)
+{
+}
+
+// 节点索引范围
+void RadixHeap::reset(size_t /*size*/)
+{
+    clear();
+}
+
+// 清空
+void RadixHeap::clear()
+{
+    for (std::vector<Entry> &bucket : buckets_)
+    {
+        bucket.clear();
+    }
+    last_ = 0;
+    size_ = 0;
+}
+
+// 键值所在的桶
+inline int RadixHeap::bucket_of(uint32_t key) const
+{
+    return key == last_ ? 0 : 32 - std::countl_zero(key ^ last_);
+}
+
+// 放入节点
+void RadixHeap::push(uint32_t index, uint32_t f, uint32_t /*g*/)
+{
+    const uint32_t key = f < last_ ? last_ : f;
+    buckets_[bucket_of(key)].push_back({ key, index });
+    ++size_;
+}
+
+// 节点的f值变小
+void RadixHeap::decrease(uint32_t index, uint32_t f, uint32_t g)
+{
+    push(index, f, g);
+}
+
+// 取出f值最小的节点
+uint32_t RadixHeap::pop()
+{
+    assert(size_ > 0);
+    if (buckets_[0].empty())
+    {
+        // 找到第一个非空的桶，以其中最小键值为基准重新分桶
+        int i = 1;
+        while (buckets_[i].empty())
+        {
+            ++i;
+        }
+
+        std::vector<Entry> &bucket = buckets_[i];
+        uint32_t minimum = bucket.front().key;
+        for (const Entry &entry : bucket)
+        {
+            minimum = entry.key < minimum ? entry.key : minimum;
+        }
+
+        last_ = minimum;
+        for (const Entry &entry : bucket)
+        {
+            buckets_[bucket_of(entry.key)].push_back(entry);
+        }
+        bucket.clear();
+    }
+
+    // 同一键值后放入的节点先取出
+    const uint32_t index = buckets_[0].back().index;
+    buckets_[0].pop_back();
+    --size_;
+    return index;
+}
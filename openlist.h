@@ -0,0 +1,133 @@
+#ifndef __OPENLIST_H__
+#define __OPENLIST_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 开启列表
+ * 作为 BasicAStar 的模板参数，在编译期选择，需要提供以下接口：
+ *   void reset(size_t size)                                节点索引范围变为 [0, size)
+ *   void clear()                                           清空
+ *   bool empty() const                                     是否为空
+ *   void push(uint32_t index, uint32_t f, uint32_t g)      放入节点
+ *   void decrease(uint32_t index, uint32_t f, uint32_t g)  节点的f值变小
+ *   uint32_t pop()                                         取出f值最小的节点，
+ *                                                          可能返回已经取出过的节点，由调用方跳过
+ */
+
+/**
+ * 二叉堆
+ * 记录每个节点在堆中的位置，decrease 为 O(log n)，
+ * f值相同时优先取出g值大的节点
+ */
+class BinaryHeap
+{
+public:
+    void reset(size_t size);
+
+    void clear();
+
+    bool empty() const;
+
+    void push(uint32_t index, uint32_t f, uint32_t g);
+
+    void decrease(uint32_t index, uint32_t f, uint32_t g);
+
+    uint32_t pop();
+
+private:
+    /**
+     * 堆元素
+     */
+    struct Entry
+    {
+        uint64_t    key;        // 高32位为f值，低32位为g值取反
+        uint32_t    index;      // 节点索引
+    };
+
+    /**
+     * 计算排序键值
+     */
+    static uint64_t make_key(uint32_t f, uint32_t g);
+
+    /**
+     * 上滤
+     */
+    void percolate_up(size_t hole);
+
+    /**
+     * 下滤
+     */
+    void percolate_down(size_t hole);
+
+private:
+    std::vector<Entry>      heap_;
+    std::vector<uint32_t>   position_;      // 节点在堆中的位置
+};
+
+/**
+ * 单调基数堆
+ * 按与上次取出的键值最高不同位分桶，push 为 O(1)，pop 均摊 O(log C)，
+ * decrease 直接放入新元素，旧元素在取出时由调用方跳过。
+ * 要求键值单调，小于上次取出值的f值按上次取出值处理，
+ * 启发函数不满足一致性时路径可能不是最优。
+ * 只按f值排序，忽略g值，f值相同的节点不按g值打破平局
+ */
+class RadixHeap
+{
+public:
+    RadixHeap();
+
+    void reset(size_t size);
+
+    void clear();
+
+    bool empty() const;
+
+    void push(uint32_t index, uint32_t f, uint32_t g);
+
+    void decrease(uint32_t index, uint32_t f, uint32_t g);
+
+    uint32_t pop();
+
+private:
+    static const int kBuckets = 33;
+
+    /**
+     * 桶元素
+     */
+    struct Entry
+    {
+        uint32_t    key;        // f值
+        uint32_t    index;      // 节点索引
+    };
+
+    /**
+     * 键值所在的桶
+     */
+    int bucket_of(uint32_t key) const;
+
+private:
+    std::vector<Entry>      buckets_[kBuckets];
+    uint32_t                last_;          // 上次取出的键值
+    size_t                  size_;
+};
+
+inline uint64_t BinaryHeap::make_key(uint32_t f, uint32_t g)
+{
+    return (uint64_t(f) << 32) | uint32_t(~g);
+}
+
+inline bool BinaryHeap::empty() const
+{
+    return heap_.empty();
+}
+
+inline bool RadixHeap::empty() const
+{
+    return size_ == 0;
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "pathcache.h"
+#include "gridmap.h"
+
+PathCache::PathCache(size_t budget)
+    : revision_(0)
+    , budget_(budget)
+    , memory_(0)
+    , hits_(0)
+    , misses_(0)
+{
+}
+
+// 使用地图自身的版本寻路
+PathCache::Path PathCache::find(AStar &algorithm, const AStar::Params &param, const GridMap &grid)
+{
+    return find(algorithm, param, grid, grid.get_revision());
+}
+
+// 清空缓存
+void PathCache::clear()
+{
+    entries_.clear();
+    index_.clear();
+    memory_ = 0;
+}
+
+// 设置内存预算
+void PathCache::set_budget(size_t budget)
+{
+    budget_ = budget;
+    shrink(budget_);
+}
+
+// 获取内存预算
+size_t PathCache::get_budget() const
+{
+    return budget_;
+}
+
+// 获取缓存占用的内存
+size_t PathCache::get_memory_usage() const
+{
+    return memory_;
+}
+
+// 获取缓存的路径数
+size_t PathCache::get_size() const
+{
+    return entries_.size();
+}
+
+// 获取命中次数
+size_t PathCache::get_hit_count() const
+{
+    return hits_;
+}
+
+// 获取未命中次数
+size_t PathCache::get_miss_count() const
+{
+    return misses_;
+}
+
+// 查找缓存
+const PathCache::Path* PathCache::lookup(const Key &key, uint64_t revision)
+{
+    // 地图已经修改，之前的路径全部作废
+    if (revision != revision_)
+    {
+        clear();
+        revision_ = revision;
+    }
+
+    auto iter = index_.find(key);
+    if (iter == index_.end())
+    {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return &iter->second->path;
+}
+
+// 放入缓存
+void PathCache::insert(const Key &key, const Path &path)
+{
+    const size_t memory = calcul_memory(path);
+    if (memory > budget_)
+    {
+        return;
+    }
+
+    shrink(budget_ - memory);
+    entries_.push_front({ key, path });
+    index_.emplace(key, entries_.begin());
+    memory_ += memory;
+}
+
+// 条目占用的内存，包括链表和哈希表节点的大致开销
+size_t PathCache::calcul_memory(const Path &path)
+{
+    return sizeof(Entry) + path.size() * sizeof(Vec2) + 4 * sizeof(void*);
+}
+
+// 淘汰最久未使用的条目
+void PathCache::shrink(size_t budget)
+{
+    while (memory_ > budget && !entries_.empty())
+    {
+        const Entry &entry = entries_.back();
+        memory_ -= calcul_memory(entry.path);
+        index_.erase(entry.key);
+        entries_.pop_back();
+    }
+}
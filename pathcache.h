@@ -0,0 +1,177 @@
+#ifndef __PATHCACHE_H__
+#define __PATHCACHE_H__
+
+#include <bit>
+#include <list>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "astar.h"
+
+class GridMap;
+
+/**
+ * 路径缓存
+ * 按(起点, 终点, 拐角, 搜索方式, 启发函数, 权重, 最近点回退, 终点数限制, 地图版本)
+ * 缓存 AStar::find 的结果，包括找不到路径的结果，
+ * 超出内存预算时淘汰最久未使用的路径。地图版本变化时旧的路径全部失效。
+ * 不是线程安全的，多线程使用时每个线程一个
+ */
+class PathCache
+{
+public:
+    typedef AStar::Vec2 Vec2;
+    typedef std::vector<Vec2> Path;
+
+    static const size_t kDefaultBudget = 4 * 1024 * 1024;
+
+public:
+    explicit PathCache(size_t budget = kDefaultBudget);
+
+public:
+    /**
+     * 执行寻路操作，命中缓存时直接返回
+     * revision 为地图版本，可通过性发生变化时必须改变
+     */
+    template<typename GridPolicy>
+    Path find(AStar &algorithm, const AStar::Params &param, GridPolicy &&can_pass, uint64_t revision);
+
+    /**
+     * 执行寻路操作，使用地图自身的版本
+     */
+    Path find(AStar &algorithm, const AStar::Params &param, const GridMap &grid);
+
+    /**
+     * 清空缓存，不影响命中统计
+     */
+    void clear();
+
+    /**
+     * 设置内存预算，超出部分立即淘汰
+     */
+    void set_budget(size_t budget);
+
+    /**
+     * 获取内存预算
+     */
+    size_t get_budget() const;
+
+    /**
+     * 获取缓存占用的内存
+     */
+    size_t get_memory_usage() const;
+
+    /**
+     * 获取缓存的路径数
+     */
+    size_t get_size() const;
+
+    /**
+     * 获取命中次数
+     */
+    size_t get_hit_count() const;
+
+    /**
+     * 获取未命中次数
+     */
+    size_t get_miss_count() const;
+
+private:
+    /**
+     * 缓存键值，地图版本相同的路径才会保留，因此不包含版本
+     */
+    struct Key
+    {
+        Vec2                start;
+        Vec2                end;
+        bool                corner;
+        AStar::Mode         mode;
+        AStar::Heuristic    heuristic;
+        float               weight;
+        bool                nearest;
+        uint32_t            goal_limit;
+
+        bool operator== (const Key &other) const
+        {
+            return start == other.start && end == other.end && corner == other.corner
+                && mode == other.mode && heuristic == other.heuristic && weight == other.weight
+                && nearest == other.nearest && goal_limit == other.goal_limit;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator() (const Key &key) const
+        {
+            const uint64_t value = (uint64_t(key.start.x) << 48) | (uint64_t(key.start.y) << 32)
+                | (uint64_t(key.end.x) << 16) | key.end.y;
+            const uint64_t options = (uint64_t(std::bit_cast<uint32_t>(key.weight)) << 32) | key.goal_limit;
+            const uint64_t flags = ((uint64_t(key.mode) * 4 + key.heuristic) * 2 + key.corner) * 2 + key.nearest;
+            size_t seed = std::hash<uint64_t>()(value);
+            seed = combine(seed, std::hash<uint64_t>()(options));
+            return combine(seed, std::hash<uint64_t>()(flags));
+        }
+
+        static size_t combine(size_t seed, size_t value)
+        {
+            return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        }
+    };
+
+    /**
+     * 缓存条目，按最近使用的顺序排列
+     */
+    struct Entry
+    {
+        Key         key;
+        Path        path;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    /**
+     * 查找缓存，命中时移到最前
+     */
+    const Path* lookup(const Key &key, uint64_t revision);
+
+    /**
+     * 放入缓存
+     */
+    void insert(const Key &key, const Path &path);
+
+    /**
+     * 条目占用的内存
+     */
+    static size_t calcul_memory(const Path &path);
+
+    /**
+     * 淘汰条目直到不超过预算
+     */
+    void shrink(size_t budget);
+
+private:
+    EntryList                                               entries_;
+    std::unordered_map<Key, EntryList::iterator, KeyHash>   index_;
+    uint64_t                                                revision_;      // 缓存内容对应的地图版本
+    size_t                                                  budget_;
+    size_t                                                  memory_;
+    size_t                                                  hits_;
+    size_t                                                  misses_;
+};
+
+// 执行寻路操作
+template<typename GridPolicy>
+PathCache::Path PathCache::find(AStar &algorithm, const AStar::Params &param, GridPolicy &&can_pass, uint64_t revision)
+{
+    const Key key = { param.start, param.end, param.corner, param.mode, param.heuristic, param.weight, param.nearest, param.goal_limit };
+    if (const Path *path = lookup(key, revision))
+    {
+        return *path;
+    }
+
+    Path path = algorithm.find(param, can_pass);
+    insert(key, path);
+    return path;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __PATHCOMPRESS_H__
+#define __PATHCOMPRESS_H__
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * 按视线压缩路径
+ * path 为包含起点的路径点，visible(a, b) 判断两点之间能否直线通过，
+ * 例如 RVOSimulator::queryVisibility(a, b, radius)。
+ * 从当前拐点出发尽量向后看，遇到看不见的点时把前一个点作为新的拐点，
+ * 结果保留起点和终点，只剩下必须拐弯的点
+ */
+template<typename Point, typename Visible>
+std::vector<Point> compress_path(const std::vector<Point> &path, Visible &&visible)
+{
+    if (path.size() <= 2)
+    {
+        return path;
+    }
+
+    std::vector<Point> compressed;
+    compressed.push_back(path.front());
+    size_t anchor = 0;
+    for (size_t i = 2; i < path.size(); ++i)
+    {
+        if (!visible(path[anchor], path[i]))
+        {
+            anchor = i - 1;
+            compressed.push_back(path[anchor]);
+        }
+    }
+    compressed.push_back(path.back());
+    return compressed;
+}
+
+#endif
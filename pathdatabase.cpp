@@ -0,0 +1,533 @@
+#include "pathdatabase.h"
+#include "gridmap.h"
+#include "openlist.h"
+#include <bit>
+#include <atomic>
+#include <thread>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // 文件头，之后依次为 offsets、passable 和 runs，各部分按8字节对齐
+    struct FileHeader
+    {
+        char        magic[4];
+        uint32_t    version;
+        uint16_t    width;
+        uint16_t    height;
+        uint32_t    corner;
+        int32_t     step_value;
+        int32_t     oblique_value;
+        uint64_t    map_hash;
+        uint64_t    run_count;
+    };
+
+    static_assert(sizeof(FileHeader) % 8 == 0, "sections after the header must stay 8-byte aligned");
+
+    const char kMagic[4] = { 'F', 'M', 'D', 'B' };
+    const uint32_t kVersion = 1;
+    const uint32_t kMoveBits = 4;
+    const uint32_t kMoveMask = (1u << kMoveBits) - 1;
+    const size_t kMaxCells = size_t(1) << (32 - kMoveBits);
+
+    // 检查文件内容，data 至少包含文件头
+    bool check_layout(const char *data, size_t length, const GridMap &map, FileHeader *out_header)
+    {
+        FileHeader &header = *out_header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+            || header.version != kVersion
+            || header.width != map.get_width()
+            || header.height != map.get_height()
+            || header.step_value != AStar::kStepValue
+            || header.oblique_value != AStar::kObliqueValue
+            || header.map_hash != map.get_hash())
+        {
+            return false;
+        }
+
+        const size_t size = size_t(header.width) * header.height;
+        const size_t words = (size + 63) / 64;
+        if (length != sizeof(header) + (size + 1) * sizeof(uint64_t) + words * sizeof(uint64_t) + header.run_count * sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        // 每行的位置不能递减，查询时不再检查
+        const char *offsets = data + sizeof(header);
+        uint64_t previous = 0;
+        for (size_t i = 0; i <= size; ++i)
+        {
+            uint64_t offset;
+            std::memcpy(&offset, offsets + i * sizeof(offset), sizeof(offset));
+            if (offset < previous || (i == 0 && offset != 0))
+            {
+                return false;
+            }
+            previous = offset;
+        }
+        if (previous != header.run_count)
+        {
+            return false;
+        }
+
+        // 每行非空时第一段从终点0开始，段的起始终点递增且不越界，方向有效，
+        // 查询时二分查找的结果总能落在本行内
+        const char *runs = offsets + (size + 1) * sizeof(uint64_t) + words * sizeof(uint64_t);
+        uint64_t begin = 0;
+        for (size_t i = 1; i <= size; ++i)
+        {
+            uint64_t end;
+            std::memcpy(&end, offsets + i * sizeof(end), sizeof(end));
+            for (uint64_t j = begin; j < end; ++j)
+            {
+                uint32_t run;
+                std::memcpy(&run, runs + j * sizeof(run), sizeof(run));
+                const uint32_t target = run >> kMoveBits;
+                if ((run & kMoveMask) > PathDatabase::kNoMove
+                    || target >= size
+                    || (j == begin && target != 0))
+                {
+                    return false;
+                }
+                if (j > begin)
+                {
+                    uint32_t last;
+                    std::memcpy(&last, runs + (j - 1) * sizeof(last), sizeof(last));
+                    if (target <= (last >> kMoveBits))
+                    {
+                        return false;
+                    }
+                }
+            }
+            begin = end;
+        }
+        return true;
+    }
+}
+
+PathDatabase::PathDatabase()
+    : width_(0)
+    , height_(0)
+    , corner_(false)
+    , map_hash_(0)
+    , offsets_(nullptr)
+    , passable_(nullptr)
+    , runs_(nullptr)
+    , run_count_(0)
+    , mapping_(nullptr)
+    , mapping_size_(0)
+{
+}
+
+PathDatabase::~PathDatabase()
+{
+    unmap();
+}
+
+// 生成数据库
+// 每个线程领取起点做 Dijkstra，首步随代价一起向外传播，代价相同的路径合并首步，
+// 压缩后的行最后按起点顺序拼接
+void PathDatabase::build(const GridMap &map, bool corner, unsigned int thread_count)
+{
+    clear();
+    width_ = map.get_width();
+    height_ = map.get_height();
+    corner_ = corner;
+    map_hash_ = map.get_hash();
+
+    const size_t size = size_t(width_) * height_;
+    assert(size <= kMaxCells);
+    passable_storage_.assign((size + 63) / 64, 0);
+    for (uint32_t index = 0; index < size; ++index)
+    {
+        if (map.can_pass(index % width_, index / width_))
+        {
+            passable_storage_[index >> 6] |= uint64_t(1) << (index & 63);
+        }
+    }
+    passable_ = passable_storage_.data();
+
+    std::vector<std::vector<uint32_t>> rows(size);
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        std::vector<uint32_t> distances(size);
+        std::vector<uint16_t> moves(size);      // 所有最优首步的掩码，第 kNoMove 位表示不可到达
+        std::vector<uint8_t> queued(size, 0);
+        BinaryHeap open_list;
+        open_list.reset(size);
+
+        while (true)
+        {
+            const size_t source = next.fetch_add(1, std::memory_order_relaxed);
+            if (source >= size)
+            {
+                break;
+            }
+            if (!can_pass(uint32_t(source)))
+            {
+                continue;
+            }
+
+            std::fill(distances.begin(), distances.end(), UINT32_MAX);
+            std::fill(moves.begin(), moves.end(), uint16_t(1 << kNoMove));
+            distances[source] = 0;
+            queued[source] = 1;
+            open_list.push(uint32_t(source), 0, 0);
+            while (!open_list.empty())
+            {
+                const uint32_t current = open_list.pop();
+                queued[current] = 0;
+
+                const Vec2 pos(current % width_, current / width_);
+                unsigned int mask = map.get_neighbour_mask(pos);
+                if (!corner_)
+                {
+                    mask &= AStar::kStraightMask;
+                }
+                while (mask != 0)
+                {
+                    const int i = std::countr_zero(mask);
+                    mask &= mask - 1;
+                    const uint32_t neighbour = uint32_t(pos.y + AStar::kNeighbourY[i]) * width_ + pos.x + AStar::kNeighbourX[i];
+                    const uint32_t distance = distances[current] + ((i & 1) ? AStar::kObliqueValue : AStar::kStepValue);
+                    const uint16_t first = current == source ? uint16_t(1 << i) : moves[current];
+                    if (distance == distances[neighbour])
+                    {
+                        moves[neighbour] |= first;
+                    }
+                    else if (distance < distances[neighbour])
+                    {
+                        distances[neighbour] = distance;
+                        moves[neighbour] = first;
+                        if (queued[neighbour])
+                        {
+                            open_list.decrease(neighbour, distance, distance);
+                        }
+                        else
+                        {
+                            queued[neighbour] = 1;
+                            open_list.push(neighbour, distance, distance);
+                        }
+                    }
+                }
+            }
+
+            // 段内所有终点共有的最优首步都可以作为这一段的方向，没有共有的首步时才开始新的一段，
+            // 第一段从0开始
+            std::vector<uint32_t> &row = rows[source];
+            uint32_t run_start = 0;
+            uint16_t run_moves = 0;
+            for (uint32_t target = 0; target < size; ++target)
+            {
+                if (target == source || !can_pass(target))
+                {
+                    continue;
+                }
+                if (run_moves == 0)
+                {
+                    run_moves = moves[target];
+                }
+                else if ((run_moves & moves[target]) == 0)
+                {
+                    row.push_back((run_start << kMoveBits) | uint32_t(std::countr_zero(run_moves)));
+                    run_start = target;
+                    run_moves = moves[target];
+                }
+                else
+                {
+                    run_moves &= moves[target];
+                }
+            }
+            if (run_moves != 0)
+            {
+                row.push_back((run_start << kMoveBits) | uint32_t(std::countr_zero(run_moves)));
+            }
+            row.shrink_to_fit();
+        }
+    };
+
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < thread_count; ++i)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    offset_storage_.resize(size + 1);
+    offset_storage_[0] = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        offset_storage_[i + 1] = offset_storage_[i] + rows[i].size();
+    }
+    run_storage_.reserve(offset_storage_[size]);
+    for (std::vector<uint32_t> &row : rows)
+    {
+        run_storage_.insert(run_storage_.end(), row.begin(), row.end());
+        std::vector<uint32_t>().swap(row);
+    }
+    offsets_ = offset_storage_.data();
+    runs_ = run_storage_.data();
+    run_count_ = run_storage_.size();
+}
+
+// 保存到文件
+bool PathDatabase::save(const char *filename) const
+{
+    std::FILE *file = std::fopen(filename, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.width = width_;
+    header.height = height_;
+    header.corner = corner_ ? 1 : 0;
+    header.step_value = AStar::kStepValue;
+    header.oblique_value = AStar::kObliqueValue;
+    header.map_hash = map_hash_;
+    header.run_count = run_count_;
+
+    const size_t size = size_t(width_) * height_;
+    const size_t offset_count = offsets_ != nullptr ? size + 1 : 0;
+    const size_t words = offsets_ != nullptr ? (size + 63) / 64 : 0;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(offsets_, sizeof(uint64_t), offset_count, file) == offset_count;
+    ok = ok && std::fwrite(passable_, sizeof(uint64_t), words, file) == words;
+    ok = ok && std::fwrite(runs_, sizeof(uint32_t), run_count_, file) == run_count_;
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+// 把文件映射到内存
+// 不支持 mmap 的平台读入整个文件
+bool PathDatabase::load(const char *filename, const GridMap &map)
+{
+    FileHeader header;
+#ifndef _WIN32
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    size_t length = 0;
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(FileHeader))
+    {
+        length = size_t(info.st_size);
+        mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    const char *data = static_cast<const char*>(mapping);
+    if (!check_layout(data, length, map, &header))
+    {
+        munmap(mapping, length);
+        return false;
+    }
+#else
+    std::FILE *file = std::fopen(filename, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    std::vector<char> buffer;
+    if (std::fseek(file, 0, SEEK_END) == 0)
+    {
+        const long length = std::ftell(file);
+        if (length >= long(sizeof(FileHeader)) && std::fseek(file, 0, SEEK_SET) == 0)
+        {
+            buffer.resize(size_t(length));
+            if (std::fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+            {
+                buffer.clear();
+            }
+        }
+    }
+    std::fclose(file);
+    if (buffer.empty() || !check_layout(buffer.data(), buffer.size(), map, &header))
+    {
+        return false;
+    }
+    const char *data = buffer.data();
+#endif
+
+    clear();
+    width_ = header.width;
+    height_ = header.height;
+    corner_ = header.corner != 0;
+    map_hash_ = header.map_hash;
+    run_count_ = size_t(header.run_count);
+
+    const size_t size = size_t(width_) * height_;
+    const char *offsets = data + sizeof(header);
+    const char *passable = offsets + (size + 1) * sizeof(uint64_t);
+    const char *runs = passable + (size + 63) / 64 * sizeof(uint64_t);
+#ifndef _WIN32
+    mapping_ = mapping;
+    mapping_size_ = length;
+    offsets_ = reinterpret_cast<const uint64_t*>(offsets);
+    passable_ = reinterpret_cast<const uint64_t*>(passable);
+    runs_ = reinterpret_cast<const uint32_t*>(runs);
+#else
+    offset_storage_.resize(size + 1);
+    passable_storage_.resize((size + 63) / 64);
+    run_storage_.resize(run_count_);
+    std::memcpy(offset_storage_.data(), offsets, offset_storage_.size() * sizeof(uint64_t));
+    std::memcpy(passable_storage_.data(), passable, passable_storage_.size() * sizeof(uint64_t));
+    std::memcpy(run_storage_.data(), runs, run_storage_.size() * sizeof(uint32_t));
+    offsets_ = offset_storage_.data();
+    passable_ = passable_storage_.data();
+    runs_ = run_storage_.data();
+#endif
+    return true;
+}
+
+// 清空数据
+void PathDatabase::clear()
+{
+    unmap();
+    std::vector<uint64_t>().swap(offset_storage_);
+    std::vector<uint64_t>().swap(passable_storage_);
+    std::vector<uint32_t>().swap(run_storage_);
+    width_ = 0;
+    height_ = 0;
+    corner_ = false;
+    map_hash_ = 0;
+    offsets_ = nullptr;
+    passable_ = nullptr;
+    runs_ = nullptr;
+    run_count_ = 0;
+}
+
+// 获取地图宽度
+uint16_t PathDatabase::get_width() const
+{
+    return width_;
+}
+
+// 获取地图高度
+uint16_t PathDatabase::get_height() const
+{
+    return height_;
+}
+
+// 是否允许斜向移动
+bool PathDatabase::is_corner() const
+{
+    return corner_;
+}
+
+// 获取压缩后的段数
+size_t PathDatabase::get_run_count() const
+{
+    return run_count_;
+}
+
+// 获取占用的内存
+size_t PathDatabase::get_memory_usage() const
+{
+    return mapping_size_
+        + offset_storage_.capacity() * sizeof(uint64_t)
+        + passable_storage_.capacity() * sizeof(uint64_t)
+        + run_storage_.capacity() * sizeof(uint32_t);
+}
+
+// 获取从起点到终点最优路径的第一步
+uint8_t PathDatabase::get_first_move(const Vec2 &start, const Vec2 &end) const
+{
+    if (start.x >= width_ || start.y >= height_ || end.x >= width_ || end.y >= height_)
+    {
+        return kNoMove;
+    }
+    return find_move(uint32_t(start.y) * width_ + start.x, uint32_t(end.y) * width_ + end.x);
+}
+
+// 查询路径
+// 每一步都在最优路径上，剩余代价严格减少，走出地图或步数超过格子数说明文件内容有误
+PathDatabase::Path PathDatabase::find(const Vec2 &start, const Vec2 &end) const
+{
+    Path paths;
+    if (start.x >= width_ || start.y >= height_ || end.x >= width_ || end.y >= height_)
+    {
+        return paths;
+    }
+    const uint32_t end_index = uint32_t(end.y) * width_ + end.x;
+    if (!can_pass(uint32_t(start.y) * width_ + start.x) || !can_pass(end_index))
+    {
+        return paths;
+    }
+
+    const size_t size = size_t(width_) * height_;
+    Vec2 current = start;
+    while (!(current == end))
+    {
+        const uint8_t move = find_move(uint32_t(current.y) * width_ + current.x, end_index);
+        if (move >= kNoMove || paths.size() >= size)
+        {
+            paths.clear();
+            break;
+        }
+        current.reset(current.x + AStar::kNeighbourX[move], current.y + AStar::kNeighbourY[move]);
+        if (current.x >= width_ || current.y >= height_ || !can_pass(uint32_t(current.y) * width_ + current.x))
+        {
+            paths.clear();
+            break;
+        }
+        paths.push_back(current);
+    }
+    return paths;
+}
+
+// 查找终点所在的段
+// 段按起始终点排列，最后一个起始终点不大于 end 的段即为所在的段
+uint8_t PathDatabase::find_move(uint32_t start, uint32_t end) const
+{
+    const uint32_t *begin = runs_ + offsets_[start];
+    const uint32_t *finish = runs_ + offsets_[start + 1];
+    if (begin == finish)
+    {
+        return kNoMove;
+    }
+    const uint32_t *run = std::upper_bound(begin, finish, (end << kMoveBits) | kMoveMask);
+    return uint8_t(run[-1] & kMoveMask);
+}
+
+// 释放映射的文件
+void PathDatabase::unmap()
+{
+#ifndef _WIN32
+    if (mapping_ != nullptr)
+    {
+        munmap(mapping_, mapping_size_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+}
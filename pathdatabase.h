@@ -0,0 +1,134 @@
+#ifndef __PATHDATABASE_H__
+#define __PATHDATABASE_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "astar.h"
+
+class GridMap;
+
+/**
+ * 路径数据库(首步表)
+ * 离线对每个可通过的起点做一次 Dijkstra，记录到每个终点最优路径的第一步方向，
+ * 查询时逐格读取首步直到终点，不需要开启列表，耗时只与路径长度有关，适用于不再变化的地图。
+ * 每个起点一行，终点按 y*width+x 排列，有共同最优首步的连续终点压缩为一段，
+ * 不可通过的终点和起点自身可以取任意方向，并入前一段。
+ * 代价与 AStar 相同，直行为10，斜向为14，斜向移动要求两侧的直行格子可通过。
+ * 文件可以直接映射到内存使用，数据按本机字节序存放
+ */
+class PathDatabase
+{
+public:
+    typedef AStar::Vec2 Vec2;
+    typedef std::vector<Vec2> Path;
+
+    static constexpr uint8_t kNoMove = 8;  // 终点不可到达
+
+public:
+    PathDatabase();
+
+    ~PathDatabase();
+
+    PathDatabase(const PathDatabase&) = delete;
+
+    PathDatabase& operator= (const PathDatabase&) = delete;
+
+public:
+    /**
+     * 生成数据库，corner 为 true 时允许斜向移动，
+     * thread_count 为参与计算的线程数(含调用线程)，为0时使用硬件线程数。
+     * 要求 width*height 不超过 2^28
+     */
+    void build(const GridMap &map, bool corner, unsigned int thread_count = 0);
+
+    /**
+     * 保存到文件，失败返回false
+     */
+    bool save(const char *filename) const;
+
+    /**
+     * 把文件映射到内存，文件损坏或者与地图的内容不一致时返回false，原有数据保持不变
+     */
+    bool load(const char *filename, const GridMap &map);
+
+    /**
+     * 清空数据
+     */
+    void clear();
+
+    /**
+     * 获取地图宽度
+     */
+    uint16_t get_width() const;
+
+    /**
+     * 获取地图高度
+     */
+    uint16_t get_height() const;
+
+    /**
+     * 是否允许斜向移动
+     */
+    bool is_corner() const;
+
+    /**
+     * 获取压缩后的段数
+     */
+    size_t get_run_count() const;
+
+    /**
+     * 获取占用的内存，包括映射的文件
+     */
+    size_t get_memory_usage() const;
+
+    /**
+     * 获取从起点到终点最优路径的第一步，返回 AStar::kNeighbourX/kNeighbourY 的下标，
+     * 不可到达时返回 kNoMove，终点不可通过或与起点相同时结果无意义
+     */
+    uint8_t get_first_move(const Vec2 &start, const Vec2 &end) const;
+
+    /**
+     * 查询路径，与 AStar::find 相同，路径不包含起点，不可到达时为空
+     */
+    Path find(const Vec2 &start, const Vec2 &end) const;
+
+private:
+    /**
+     * 是否可通过，参数为格子索引
+     */
+    bool can_pass(uint32_t index) const;
+
+    /**
+     * 查找终点所在的段，返回方向
+     */
+    uint8_t find_move(uint32_t start, uint32_t end) const;
+
+    /**
+     * 释放映射的文件
+     */
+    void unmap();
+
+private:
+    uint16_t                width_;
+    uint16_t                height_;
+    bool                    corner_;
+    uint64_t                map_hash_;
+    const uint64_t*         offsets_;           // 每个起点的第一段在 runs_ 中的位置，共 width*height+1 个
+    const uint64_t*         passable_;          // 可通过的格子，每个格子1位
+    const uint32_t*         runs_;              // 每段高28位为起始终点，低4位为方向
+    size_t                  run_count_;
+    std::vector<uint64_t>   offset_storage_;    // 生成或不能映射时的数据
+    std::vector<uint64_t>   passable_storage_;
+    std::vector<uint32_t>   run_storage_;
+    void*                   mapping_;           // 映射的文件
+    size_t                  mapping_size_;
+};
+
+// 是否可通过
+inline bool PathDatabase::can_pass(uint32_t index) const
+{
+    return ((passable_[index >> 6] >> (index & 63)) & 1) != 0;
+}
+
+#endif
@@ -0,0 +1,250 @@
+#include "pathservice.h"
+#include "gridmap.h"
+#include <algorithm>
+
+PathService::Ticket::Ticket(std::shared_ptr<std::atomic<bool>> cancelled)
+    : cancelled_(std::move(cancelled))
+{
+}
+
+// 取消请求
+void PathService::Ticket::cancel()
+{
+    if (cancelled_ != nullptr)
+    {
+        cancelled_->store(true, std::memory_order_relaxed);
+    }
+}
+
+// 请求是否已取消
+bool PathService::Ticket::is_cancelled() const
+{
+    return cancelled_ != nullptr && cancelled_->load(std::memory_order_relaxed);
+}
+
+// 句柄是否对应请求
+bool PathService::Ticket::is_valid() const
+{
+    return cancelled_ != nullptr;
+}
+
+PathService::PathService(const GridMap &grid, unsigned int thread_count)
+    : grid_(grid)
+    , incoming_(nullptr)
+    , completed_(nullptr)
+    , signal_(0)
+    , sequence_(0)
+    , dropped_(0)
+    , stop_(false)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < thread_count; ++i)
+    {
+        algorithms_.push_back(std::make_unique<AStar>());
+    }
+    for (unsigned int i = 0; i < thread_count; ++i)
+    {
+        threads_.emplace_back(&PathService::worker_main, this, i);
+    }
+}
+
+PathService::~PathService()
+{
+    stop_.store(true, std::memory_order_release);
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+    for (std::thread &thread : threads_)
+    {
+        thread.join();
+    }
+
+    // 没有处理的请求直接释放，future 得到 broken_promise
+    delete_list(incoming_.exchange(nullptr));
+    delete_list(completed_.exchange(nullptr));
+    for (Request *request : queue_)
+    {
+        delete request;
+    }
+}
+
+// 提交请求，结果通过回调交付
+PathService::Ticket PathService::submit(const AStar::Params &param, int priority, Callback callback)
+{
+    auto request = std::make_unique<Request>();
+    request->param = param;
+    request->priority = priority;
+    request->callback = std::move(callback);
+    return push(std::move(request));
+}
+
+// 提交请求，结果通过 future 交付
+std::future<PathService::Path> PathService::submit(const AStar::Params &param, int priority, Ticket *out_ticket)
+{
+    auto request = std::make_unique<Request>();
+    request->param = param;
+    request->priority = priority;
+    std::future<Path> future = request->promise.get_future();
+    Ticket ticket = push(std::move(request));
+    if (out_ticket != nullptr)
+    {
+        *out_ticket = std::move(ticket);
+    }
+    return future;
+}
+
+// 执行已完成请求的回调
+size_t PathService::poll()
+{
+    // 完成栈是后进先出的，反转后按完成顺序回调
+    Request *head = completed_.exchange(nullptr, std::memory_order_acquire);
+    Request *ordered = nullptr;
+    while (head != nullptr)
+    {
+        Request *next = head->next;
+        head->next = ordered;
+        ordered = head;
+        head = next;
+    }
+
+    size_t count = 0;
+    while (ordered != nullptr)
+    {
+        std::unique_ptr<Request> request(ordered);
+        ordered = ordered->next;
+        if (!request->cancelled->load(std::memory_order_relaxed))
+        {
+            request->callback(std::move(request->path));
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 取得地图的独占锁
+std::unique_lock<std::shared_mutex> PathService::lock_map()
+{
+    std::lock_guard<std::mutex> gate(gate_mutex_);
+    return std::unique_lock<std::shared_mutex>(map_mutex_);
+}
+
+// 获取工作线程数
+size_t PathService::get_thread_count() const
+{
+    return threads_.size();
+}
+
+// 获取因取消而丢弃的请求数
+size_t PathService::get_dropped_count() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+// 放入请求并唤醒一个工作线程
+PathService::Ticket PathService::push(std::unique_ptr<Request> request)
+{
+    request->sequence = sequence_.fetch_add(1, std::memory_order_relaxed);
+    request->cancelled = std::make_shared<std::atomic<bool>>(false);
+    Ticket ticket(request->cancelled);
+
+    push_stack(incoming_, request.release());
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+    return ticket;
+}
+
+// 领取优先级最高的未取消请求
+std::unique_ptr<PathService::Request> PathService::take()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+
+    // 把新提交的请求移入优先队列
+    Request *head = incoming_.exchange(nullptr, std::memory_order_acquire);
+    while (head != nullptr)
+    {
+        Request *next = head->next;
+        queue_.push_back(head);
+        std::push_heap(queue_.begin(), queue_.end(), lower_priority);
+        head = next;
+    }
+
+    while (!queue_.empty())
+    {
+        std::pop_heap(queue_.begin(), queue_.end(), lower_priority);
+        std::unique_ptr<Request> request(queue_.back());
+        queue_.pop_back();
+        if (!request->cancelled->load(std::memory_order_relaxed))
+        {
+            return request;
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+// 工作线程主循环
+void PathService::worker_main(size_t index)
+{
+    AStar &algorithm = *algorithms_[index];
+    while (!stop_.load(std::memory_order_acquire))
+    {
+        // 先读取信号再领取请求，领取之后的提交会改变信号，等待立即返回
+        const uint32_t signal = signal_.load(std::memory_order_acquire);
+        std::unique_ptr<Request> request = take();
+        if (request == nullptr)
+        {
+            signal_.wait(signal, std::memory_order_acquire);
+            continue;
+        }
+
+        {
+            {
+                std::lock_guard<std::mutex> gate(gate_mutex_);
+            }
+            std::shared_lock<std::shared_mutex> lock(map_mutex_);
+            request->path = algorithm.find(request->param, grid_);
+        }
+
+        if (request->callback)
+        {
+            push_stack(completed_, request.release());
+        }
+        else
+        {
+            request->promise.set_value(std::move(request->path));
+        }
+    }
+}
+
+// 无锁栈放入节点
+void PathService::push_stack(std::atomic<Request*> &head, Request *request)
+{
+    request->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(request->next, request, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+// 释放链表中的全部请求
+void PathService::delete_list(Request *head)
+{
+    while (head != nullptr)
+    {
+        Request *next = head->next;
+        delete head;
+        head = next;
+    }
+}
+
+// 优先级低的排在后面，同一优先级后提交的排在后面
+bool PathService::lower_priority(const Request *a, const Request *b)
+{
+    if (a->priority != b->priority)
+    {
+        return a->priority < b->priority;
+    }
+    return a->sequence > b->sequence;
+}
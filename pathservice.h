@@ -0,0 +1,169 @@
+#ifndef __PATHSERVICE_H__
+#define __PATHSERVICE_H__
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <future>
+#include <functional>
+#include "astar.h"
+
+class GridMap;
+
+/**
+ * 异步寻路服务
+ * 请求通过无锁栈提交，提交线程不会被阻塞；常驻的工作线程各自持有一个 AStar，
+ * 按优先级从高到低、同一优先级先提交先处理的顺序领取请求。
+ * 结果通过 future 交付，或者保存起来等提交线程调用 poll 时执行回调。
+ * 已取消的请求在被领取时直接丢弃，不会执行寻路
+ */
+class PathService
+{
+public:
+    typedef AStar::Vec2 Vec2;
+    typedef std::vector<Vec2> Path;
+    typedef std::function<void(Path&&)> Callback;
+
+    /**
+     * 请求句柄，用于取消请求，可以复制，全部销毁后不影响请求
+     */
+    class Ticket
+    {
+    public:
+        Ticket() = default;
+
+    public:
+        /**
+         * 取消请求，尚未开始的请求不再执行，已完成的请求不再回调
+         */
+        void cancel();
+
+        /**
+         * 请求是否已取消
+         */
+        bool is_cancelled() const;
+
+        /**
+         * 句柄是否对应请求
+         */
+        bool is_valid() const;
+
+    private:
+        friend class PathService;
+
+        explicit Ticket(std::shared_ptr<std::atomic<bool>> cancelled);
+
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled_;
+    };
+
+public:
+    /**
+     * grid 在服务期间保持有效，修改前需要通过 lock_map 取得独占锁。
+     * thread_count 为工作线程数，为0时使用硬件线程数
+     */
+    explicit PathService(const GridMap &grid, unsigned int thread_count = 0);
+
+    ~PathService();
+
+    PathService(const PathService&) = delete;
+
+    PathService& operator= (const PathService&) = delete;
+
+public:
+    /**
+     * 提交请求，完成后在 poll 中执行回调。优先级越大越先处理
+     */
+    Ticket submit(const AStar::Params &param, int priority, Callback callback);
+
+    /**
+     * 提交请求，结果通过 future 交付，请求被取消时 future 抛出 broken_promise
+     */
+    std::future<Path> submit(const AStar::Params &param, int priority, Ticket *out_ticket = nullptr);
+
+    /**
+     * 执行已完成请求的回调，返回执行的回调数。只能由一个线程调用，通常每帧一次
+     */
+    size_t poll();
+
+    /**
+     * 取得地图的独占锁，持有期间工作线程不会读取地图，正在进行的寻路先完成
+     */
+    std::unique_lock<std::shared_mutex> lock_map();
+
+    /**
+     * 获取工作线程数
+     */
+    size_t get_thread_count() const;
+
+    /**
+     * 获取因取消而丢弃的请求数
+     */
+    size_t get_dropped_count() const;
+
+private:
+    /**
+     * 请求，在提交栈、优先队列和完成栈之间传递，同一时间只属于一处
+     */
+    struct Request
+    {
+        Request*                            next;
+        int                                 priority;
+        uint64_t                            sequence;   // 提交顺序
+        AStar::Params                       param;
+        std::shared_ptr<std::atomic<bool>>  cancelled;
+        Callback                            callback;
+        std::promise<Path>                  promise;    // 没有回调时通过 future 交付
+        Path                                path;
+    };
+
+    /**
+     * 放入请求并唤醒一个工作线程
+     */
+    Ticket push(std::unique_ptr<Request> request);
+
+    /**
+     * 领取优先级最高的未取消请求，没有时返回空
+     */
+    std::unique_ptr<Request> take();
+
+    /**
+     * 工作线程主循环
+     */
+    void worker_main(size_t index);
+
+    /**
+     * 无锁栈放入节点
+     */
+    static void push_stack(std::atomic<Request*> &head, Request *request);
+
+    /**
+     * 释放链表中的全部请求
+     */
+    static void delete_list(Request *head);
+
+    /**
+     * 优先队列的比较函数
+     */
+    static bool lower_priority(const Request *a, const Request *b);
+
+private:
+    const GridMap&                      grid_;
+    std::vector<std::unique_ptr<AStar>> algorithms_;    // 每个工作线程一个
+    std::vector<std::thread>            threads_;
+    std::atomic<Request*>               incoming_;      // 已提交的请求，无锁栈
+    std::atomic<Request*>               completed_;     // 等待回调的请求，无锁栈
+    std::atomic<uint32_t>               signal_;        // 每次提交加一，空闲的工作线程在此等待
+    std::atomic<uint64_t>               sequence_;
+    std::atomic<size_t>                 dropped_;
+    std::atomic<bool>                   stop_;
+    std::mutex                          queue_mutex_;   // 只在工作线程之间竞争
+    std::vector<Request*>               queue_;         // 按优先级排列的堆
+    std::mutex                          gate_mutex_;    // 等待独占锁期间阻止新的读取，避免修改地图的线程饿死
+    std::shared_mutex                   map_mutex_;
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include "subgoalgraph.h"
+#include "gridmap.h"
+#include <algorithm>
+#include <cassert>
+
+SubgoalGraph::SubgoalGraph()
+    : map_(nullptr)
+    , node_count_(0)
+    , generation_(0)
+    , expanded_(0)
+{
+}
+
+// 建立子目标图
+// 从每个子目标扫描可以直接到达的子目标，扫描的结果不一定对称，两个方向都连边
+void SubgoalGraph::build(const GridMap &map)
+{
+    map_ = &map;
+    const int width = map.get_width();
+    const int height = map.get_height();
+    node_ids_.assign(size_t(width) * height, kUnreachable);
+    nodes_.clear();
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (!map.can_pass(x, y))
+            {
+                continue;
+            }
+            for (int i = 1; i < 8; i += 2)
+            {
+                const int dx = AStar::kNeighbourX[i];
+                const int dy = AStar::kNeighbourY[i];
+                if (!map.can_pass(x + dx, y + dy) && map.can_pass(x + dx, y) && map.can_pass(x, y + dy))
+                {
+                    node_ids_[size_t(y) * width + x] = uint32_t(nodes_.size());
+                    nodes_.push_back(Vec2(x, y));
+                    break;
+                }
+            }
+        }
+    }
+    node_count_ = uint32_t(nodes_.size());
+
+    std::vector<std::vector<uint32_t>> adjacency(node_count_);
+    for (uint32_t id = 0; id < node_count_; ++id)
+    {
+        scan_reachable(nodes_[id], kUnreachable, &cells_);
+        for (uint32_t cell : cells_)
+        {
+            const uint32_t neighbour = node_ids_[cell];
+            adjacency[id].push_back(neighbour);
+            adjacency[neighbour].push_back(id);
+        }
+    }
+
+    edge_offsets_.assign(1, 0);
+    edges_.clear();
+    for (std::vector<uint32_t> &neighbours : adjacency)
+    {
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        edges_.insert(edges_.end(), neighbours.begin(), neighbours.end());
+        edge_offsets_.push_back(uint32_t(edges_.size()));
+    }
+    edges_.shrink_to_fit();
+
+    const size_t size = size_t(node_count_) + 2;
+    g_.resize(size);
+    parent_.resize(size);
+    states_.assign(size, 0);
+    end_links_.assign(size, 0);
+    generation_ = 0;
+    open_list_.reset(size);
+}
+
+// 在子目标图上寻路
+// 不是子目标的起点和终点临时接入，终点一侧的边记录在 end_links_ 中，搜索到这些节点时再连向终点
+bool SubgoalGraph::find_abstract(const Vec2 &start, const Vec2 &end, std::vector<Vec2> *out_nodes)
+{
+    out_nodes->clear();
+    expanded_ = 0;
+    assert(map_ != nullptr);
+    if (map_ == nullptr
+        || start.x >= map_->get_width() || start.y >= map_->get_height()
+        || end.x >= map_->get_width() || end.y >= map_->get_height()
+        || !map_->can_pass(start) || !map_->can_pass(end))
+    {
+        return false;
+    }
+    if (map_->has_components() && map_->get_component(start) != map_->get_component(end))
+    {
+        return false;
+    }
+
+    if (start == end)
+    {
+        out_nodes->push_back(start);
+        return true;
+    }
+
+    start_ = start;
+    end_ = end;
+    const uint32_t start_index = to_index(start);
+    const uint32_t end_index = to_index(end);
+    const uint32_t start_id = node_ids_[start_index] != kUnreachable ? node_ids_[start_index] : node_count_;
+    const uint32_t end_id = node_ids_[end_index] != kUnreachable ? node_ids_[end_index] : node_count_ + 1;
+
+    // 新的搜索代数
+    generation_ += 2;
+    if (generation_ < 2)
+    {
+        std::fill(states_.begin(), states_.end(), 0);
+        std::fill(end_links_.begin(), end_links_.end(), 0);
+        generation_ = 2;
+    }
+    open_list_.clear();
+
+    if (start_id == node_count_)
+    {
+        scan_reachable(start, end_index, &cells_);
+        start_edges_.clear();
+        for (uint32_t cell : cells_)
+        {
+            start_edges_.push_back(cell == end_index ? end_id : node_ids_[cell]);
+        }
+    }
+    if (end_id == node_count_ + 1)
+    {
+        scan_reachable(end, start_index, &cells_);
+        for (uint32_t cell : cells_)
+        {
+            end_links_[cell == start_index ? start_id : node_ids_[cell]] = generation_;
+        }
+    }
+
+    g_[start_id] = 0;
+    parent_[start_id] = kUnreachable;
+    states_[start_id] = generation_;
+    open_list_.push(start_id, calcul_h_value(start, end), 0);
+
+    while (!open_list_.empty())
+    {
+        const uint32_t current = open_list_.pop();
+        if (states_[current] != generation_)
+        {
+            continue;
+        }
+        states_[current] = generation_ + 1;
+        ++expanded_;
+
+        if (current == end_id)
+        {
+            for (uint32_t id = end_id; id != kUnreachable; id = parent_[id])
+            {
+                out_nodes->push_back(get_node_pos(id));
+            }
+            std::reverse(out_nodes->begin(), out_nodes->end());
+            return true;
+        }
+
+        if (current == node_count_)
+        {
+            for (uint32_t neighbour : start_edges_)
+            {
+                relax(current, neighbour, end);
+            }
+        }
+        else
+        {
+            for (uint32_t i = edge_offsets_[current]; i < edge_offsets_[current + 1]; ++i)
+            {
+                relax(current, edges_[i], end);
+            }
+        }
+        if (end_links_[current] == generation_)
+        {
+            relax(current, end_id, end);
+        }
+    }
+    return false;
+}
+
+// 细化相邻的两个子目标
+// 从任意一端出发先斜走再直走总有一个方向可以通过
+std::vector<SubgoalGraph::Vec2> SubgoalGraph::refine(const Vec2 &from, const Vec2 &to) const
+{
+    std::vector<Vec2> paths;
+    if (walk(from, to, &paths))
+    {
+        return paths;
+    }
+
+    paths.clear();
+    if (walk(to, from, &paths))
+    {
+        paths.pop_back();
+        std::reverse(paths.begin(), paths.end());
+        paths.push_back(to);
+        return paths;
+    }
+
+    assert(false);
+    return std::vector<Vec2>();
+}
+
+// 执行寻路操作
+std::vector<SubgoalGraph::Vec2> SubgoalGraph::find(const Vec2 &start, const Vec2 &end)
+{
+    std::vector<Vec2> paths;
+    std::vector<Vec2> nodes;
+    if (!find_abstract(start, end, &nodes))
+    {
+        return paths;
+    }
+
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        const std::vector<Vec2> segment = refine(nodes[i - 1], nodes[i]);
+        paths.insert(paths.end(), segment.begin(), segment.end());
+    }
+    return paths;
+}
+
+// 获取上次寻路扩展的节点数
+size_t SubgoalGraph::get_expanded_count() const
+{
+    return expanded_;
+}
+
+// 获取子目标数
+size_t SubgoalGraph::get_node_count() const
+{
+    return node_count_;
+}
+
+// 获取边数
+size_t SubgoalGraph::get_edge_count() const
+{
+    return edges_.size();
+}
+
+// 获取占用的内存
+size_t SubgoalGraph::get_memory_usage() const
+{
+    return node_ids_.capacity() * sizeof(uint32_t)
+        + nodes_.capacity() * sizeof(Vec2)
+        + edge_offsets_.capacity() * sizeof(uint32_t)
+        + edges_.capacity() * sizeof(uint32_t)
+        + (g_.capacity() + parent_.capacity() + states_.capacity() + end_links_.capacity()) * sizeof(uint32_t);
+}
+
+// 从格子出发沿一个方向可走的步数
+int SubgoalGraph::calcul_clearance(const Vec2 &pos, int direction, uint32_t extra, bool *out_hit) const
+{
+    int count = 0;
+    Vec2 current = pos;
+    while ((map_->get_neighbour_mask(current) >> direction) & 1)
+    {
+        current.reset(current.x + AStar::kNeighbourX[direction], current.y + AStar::kNeighbourY[direction]);
+        const uint32_t index = to_index(current);
+        if (node_ids_[index] != kUnreachable || index == extra)
+        {
+            *out_hit = true;
+            return count;
+        }
+        ++count;
+    }
+    *out_hit = false;
+    return count;
+}
+
+// 查找可以直接到达的子目标
+// 先沿四个直行方向扫描，再沿每个斜向逐格前进，从斜线上的每个格子向两侧的直行方向扫描。
+// 直行方向可走的步数只能逐行减少，越过之前的障碍物或子目标的格子总有经过子目标的同样短的路径
+void SubgoalGraph::scan_reachable(const Vec2 &pos, uint32_t extra, std::vector<uint32_t> *out_cells) const
+{
+    out_cells->clear();
+    auto add = [&](const Vec2 &from, int direction, int steps)
+    {
+        out_cells->push_back(to_index(Vec2(from.x + AStar::kNeighbourX[direction] * steps, from.y + AStar::kNeighbourY[direction] * steps)));
+    };
+
+    bool hit = false;
+    for (int i = 0; i < 8; i += 2)
+    {
+        const int steps = calcul_clearance(pos, i, extra, &hit);
+        if (hit)
+        {
+            add(pos, i, steps + 1);
+        }
+    }
+
+    for (int i = 1; i < 8; i += 2)
+    {
+        const int cardinals[2] = { i - 1, (i + 1) & 7 };
+        int limits[2];
+        for (int k = 0; k < 2; ++k)
+        {
+            limits[k] = calcul_clearance(pos, cardinals[k], extra, &hit);
+        }
+
+        const int diagonal = calcul_clearance(pos, i, extra, &hit);
+        if (hit)
+        {
+            add(pos, i, diagonal + 1);
+        }
+        for (int step = 1; step <= diagonal; ++step)
+        {
+            const Vec2 current(pos.x + AStar::kNeighbourX[i] * step, pos.y + AStar::kNeighbourY[i] * step);
+            for (int k = 0; k < 2; ++k)
+            {
+                int steps = calcul_clearance(current, cardinals[k], extra, &hit);
+                if (hit && steps <= limits[k])
+                {
+                    add(current, cardinals[k], steps + 1);
+                    --steps;
+                }
+                limits[k] = std::min(limits[k], steps);
+            }
+        }
+    }
+}
+
+// 先斜走再直走
+bool SubgoalGraph::walk(const Vec2 &from, const Vec2 &to, std::vector<Vec2> *out_paths) const
+{
+    Vec2 current = from;
+    while (!(current == to))
+    {
+        const int sx = (to.x > current.x) - (to.x < current.x);
+        const int sy = (to.y > current.y) - (to.y < current.y);
+        int direction = 0;
+        while (AStar::kNeighbourX[direction] != sx || AStar::kNeighbourY[direction] != sy)
+        {
+            ++direction;
+        }
+        if (((map_->get_neighbour_mask(current) >> direction) & 1) == 0)
+        {
+            return false;
+        }
+        current.reset(current.x + sx, current.y + sy);
+        out_paths->push_back(current);
+    }
+    return true;
+}
+
+// 计算H值，八方向距离
+uint32_t SubgoalGraph::calcul_h_value(const Vec2 &current, const Vec2 &end) const
+{
+    const int dx = abs(end.x - current.x);
+    const int dy = abs(end.y - current.y);
+    const int oblique = std::min(dx, dy);
+    return oblique * AStar::kObliqueValue + (std::max(dx, dy) - oblique) * AStar::kStepValue;
+}
+
+// 节点的坐标
+SubgoalGraph::Vec2 SubgoalGraph::get_node_pos(uint32_t id) const
+{
+    if (id == node_count_)
+    {
+        return start_;
+    }
+    if (id == node_count_ + 1)
+    {
+        return end_;
+    }
+    return nodes_[id];
+}
+
+// 格子索引
+uint32_t SubgoalGraph::to_index(const Vec2 &pos) const
+{
+    return uint32_t(pos.y) * map_->get_width() + pos.x;
+}
+
+// 松弛子目标图上的边，代价即八方向距离
+void SubgoalGraph::relax(uint32_t from, uint32_t to, const Vec2 &end)
+{
+    if (states_[to] == generation_ + 1)
+    {
+        return;
+    }
+
+    const Vec2 pos = get_node_pos(to);
+    const uint32_t g_value = g_[from] + calcul_h_value(get_node_pos(from), pos);
+    if (states_[to] == generation_)
+    {
+        if (g_value < g_[to])
+        {
+            g_[to] = g_value;
+            parent_[to] = from;
+            open_list_.decrease(to, g_value + calcul_h_value(pos, end), g_value);
+        }
+        return;
+    }
+
+    g_[to] = g_value;
+    parent_[to] = from;
+    states_[to] = generation_;
+    open_list_.push(to, g_value + calcul_h_value(pos, end), g_value);
+}
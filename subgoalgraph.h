@@ -0,0 +1,129 @@
+#ifndef __SUBGOALGRAPH_H__
+#define __SUBGOALGRAPH_H__
+
+#include <vector>
+#include <cstdint>
+#include "astar.h"
+#include "openlist.h"
+
+class GridMap;
+
+/**
+ * 子目标图(Simple Subgoal Graph)
+ * 障碍物的凸角旁边的格子作为子目标，即斜向相邻的格子不可通过而两侧的直行格子可通过的格子。
+ * 两个子目标之间存在代价等于八方向距离、且中途不经过其他子目标的路径时连一条边，
+ * 这样的路径总可以先斜走再直走(或反过来)得到。
+ * 寻路时起点和终点临时接入子目标图，在子目标图上搜索，按需把相邻的子目标细化为格子路径。
+ * 只适用于允许拐角的寻路，代价与 AStar 相同，地图修改后需要重新生成
+ */
+class SubgoalGraph
+{
+public:
+    typedef AStar::Vec2 Vec2;
+
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+public:
+    SubgoalGraph();
+
+public:
+    /**
+     * 为地图建立子目标图，地图需要在使用期间保持有效
+     */
+    void build(const GridMap &map);
+
+    /**
+     * 在子目标图上寻路，输出依次经过的子目标，包含起点和终点
+     */
+    bool find_abstract(const Vec2 &start, const Vec2 &end, std::vector<Vec2> *out_nodes);
+
+    /**
+     * 细化相邻的两个子目标，返回不含起点的格子路径
+     */
+    std::vector<Vec2> refine(const Vec2 &from, const Vec2 &to) const;
+
+    /**
+     * 执行寻路操作，返回不含起点的格子路径，与 AStar::find 一致
+     */
+    std::vector<Vec2> find(const Vec2 &start, const Vec2 &end);
+
+    /**
+     * 获取上次寻路扩展的节点数
+     */
+    size_t get_expanded_count() const;
+
+    /**
+     * 获取子目标数
+     */
+    size_t get_node_count() const;
+
+    /**
+     * 获取边数，两个方向各算一条
+     */
+    size_t get_edge_count() const;
+
+    /**
+     * 获取占用的内存
+     */
+    size_t get_memory_usage() const;
+
+private:
+    /**
+     * 从格子出发沿一个方向可走的步数，遇到不可通过的格子或者子目标时停止，
+     * out_hit 输出停止的原因是否为子目标，extra 为临时视为子目标的格子索引
+     */
+    int calcul_clearance(const Vec2 &pos, int direction, uint32_t extra, bool *out_hit) const;
+
+    /**
+     * 查找从格子出发先斜走再直走可以直接到达的子目标，输出格子索引
+     */
+    void scan_reachable(const Vec2 &pos, uint32_t extra, std::vector<uint32_t> *out_cells) const;
+
+    /**
+     * 先斜走再直走，全部可以通过时输出不含起点的格子路径
+     */
+    bool walk(const Vec2 &from, const Vec2 &to, std::vector<Vec2> *out_paths) const;
+
+    /**
+     * 计算H值
+     */
+    uint32_t calcul_h_value(const Vec2 &current, const Vec2 &end) const;
+
+    /**
+     * 节点的坐标
+     */
+    Vec2 get_node_pos(uint32_t id) const;
+
+    /**
+     * 格子索引
+     */
+    uint32_t to_index(const Vec2 &pos) const;
+
+    /**
+     * 松弛子目标图上的边
+     */
+    void relax(uint32_t from, uint32_t to, const Vec2 &end);
+
+private:
+    const GridMap*          map_;
+    std::vector<uint32_t>   node_ids_;      // 每个格子对应的子目标编号，不是子目标为kUnreachable
+    std::vector<Vec2>       nodes_;         // 子目标的坐标
+    std::vector<uint32_t>   edge_offsets_;  // 每个子目标的第一条边在 edges_ 中的位置
+    std::vector<uint32_t>   edges_;         // 相邻的子目标编号
+    uint32_t                node_count_;
+
+    // 搜索状态，起点和终点使用最后两个编号
+    std::vector<uint32_t>   g_;
+    std::vector<uint32_t>   parent_;
+    std::vector<uint32_t>   states_;        // 等于generation_为开启，加一为关闭
+    std::vector<uint32_t>   end_links_;     // 等于generation_时与终点相连
+    uint32_t                generation_;
+    BinaryHeap              open_list_;
+    std::vector<uint32_t>   start_edges_;   // 起点可以直接到达的节点
+    std::vector<uint32_t>   cells_;
+    Vec2                    start_;
+    Vec2                    end_;
+    size_t                  expanded_;
+};
+
+#endif